@@ -0,0 +1,453 @@
+#include <json5/json5.hpp>
+#include <json5/json5_binary.hpp>
+#include <json5/json5_files.hpp>
+#include <json5/json5_filter.hpp>
+#include <json5/json5_input.hpp>
+#include <json5/json5_output.hpp>
+#include <json5/json5_reflect.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+
+/*
+	Benchmark suite. Corpora are generated from a fixed seed, so results are comparable between runs and machines.
+	Throughput is reported in MB/s of corpus text (binary encodings too), together with library allocations per
+	iteration. Operations with an allocation budget fail the run when they allocate more, so allocation free paths
+	stay that way. Allocations are only counted when the hooks are compiled in (ReleaseAllocations configuration),
+	other configurations time the code as shipped and report zero allocations.
+	Results are printed and written as JSON5:
+
+	bench [output.json5] [min-time-ms]
+*/
+
+//---------------------------------------------------------------------------------------------------------------------
+struct BenchResult
+{
+	std::string corpus;
+	std::string operation;
+	size_t bytes = 0;
+	size_t iterations = 0;
+	double ms_per_iteration = 0.0;
+	double mb_per_s = 0.0;
+	uint64_t allocations = 0;
+	bool over_budget = false;
+
+	JSON5_MEMBERS( corpus, operation, bytes, iterations, ms_per_iteration, mb_per_s, allocations, over_budget )
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct BenchReport
+{
+	std::string compiler;
+	std::string build;
+	std::vector<BenchResult> results;
+
+	JSON5_MEMBERS( compiler, build, results )
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct User
+{
+	std::string screen_name;
+	std::string name;
+	int followers_count = 0;
+	bool verified = false;
+
+	JSON5_MEMBERS( screen_name, name, followers_count, verified )
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct Status
+{
+	double id = 0.0;
+	std::string id_str;
+	std::string text;
+	std::string lang;
+	int retweet_count = 0;
+	User user;
+	std::vector<std::string> hashtags;
+
+	JSON5_MEMBERS( id, id_str, text, lang, retweet_count, user, hashtags )
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct Timeline
+{
+	std::vector<Status> statuses;
+
+	JSON5_MEMBERS( statuses )
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct Record
+{
+	int id = -42;
+	std::vector<float> samples = { 0.5f, -2.0f, 1e6f };
+	std::map<std::string, int> tags = { { "x", 1 } };
+	double grid[2][2] = { { 1, 2 }, { 3, 4.5 } };
+	bool flag = true;
+
+	JSON5_MEMBERS( id, samples, tags, grid, flag )
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+class CorpusGenerator
+{
+public:
+	// Twitter-like: many short objects with strings, escapes and non-ASCII text
+	std::string Twitter( size_t numStatuses )
+	{
+		static const char *words[] = { "json", "parser", "fast", "\\u00e9t\\u00e9", "\\\"quoted\\\"", "line\\nbreak", "日本語", "テスト",
+		                               "value", "document", "array", "object", "stream", "emoji 😀", "tab\\tstop" };
+		static const char *langs[] = { "en", "ja", "es", "de" };
+
+		std::string result = "{\"statuses\":[";
+		for ( size_t i = 0; i < numStatuses; ++i )
+		{
+			auto id = std::to_string( 505874924095815681ull + i * 7919 );
+
+			result += i ? "," : "";
+			result += "{\"id\":" + id + ",\"id_str\":\"" + id + "\",\"text\":\"";
+			for ( size_t w = 0, n = 5 + Next( 20 ); w < n; ++w )
+				result += std::string( w ? " " : "" ) + words[Next( std::size( words ) )];
+
+			result += "\",\"lang\":\"" + std::string( langs[Next( std::size( langs ) )] ) + "\"";
+			result += ",\"retweet_count\":" + std::to_string( Next( 1000 ) );
+			result += ",\"user\":{\"screen_name\":\"user_" + std::to_string( Next( 100000 ) ) + "\",\"name\":\"Name " +
+			          std::to_string( i ) + "\",\"followers_count\":" + std::to_string( Next( 1000000 ) ) +
+			          ",\"verified\":" + ( Next( 10 ) == 0 ? "true" : "false" ) + "}";
+
+			result += ",\"hashtags\":[";
+			for ( size_t h = 0, n = Next( 4 ); h < n; ++h )
+				result += std::string( h ? "," : "" ) + "\"tag" + std::to_string( Next( 500 ) ) + "\"";
+
+			result += "]}";
+		}
+
+		return result + "]}";
+	}
+
+	// Canada-like: one large polygon of coordinate pairs with full precision numbers
+	std::string Canada( size_t numPoints )
+	{
+		std::uniform_real_distribution<double> lon( -141.0, -52.0 ), lat( 41.0, 83.0 );
+
+		std::string result = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[";
+		char buff[64];
+		for ( size_t i = 0; i < numPoints; ++i )
+		{
+			snprintf( buff, sizeof( buff ), "%s[%.15g,%.15g]", i ? "," : "", lon( _rng ), lat( _rng ) );
+			result += buff;
+		}
+
+		return result + "]]}}]}";
+	}
+
+	// Deeply nested arrays and objects
+	std::string Deep( size_t depth, size_t repeat )
+	{
+		std::string result = "[";
+		for ( size_t r = 0; r < repeat; ++r )
+		{
+			result += r ? "," : "";
+			for ( size_t d = 0; d < depth; ++d )
+				result += ( d % 2 ) ? "{\"k\":" : "[";
+
+			result += std::to_string( r );
+			for ( size_t d = depth; d-- > 0; )
+				result += ( d % 2 ) ? "}" : "]";
+		}
+
+		return result + "]";
+	}
+
+	// Single object with many keys
+	std::string Wide( size_t numKeys )
+	{
+		std::string result = "{";
+		for ( size_t i = 0; i < numKeys; ++i )
+			result += ( i ? ",\"key_" : "\"key_" ) + std::to_string( i ) + "\":" + std::to_string( Next( 1000000 ) );
+
+		return result + "}";
+	}
+
+	// Newline delimited small records, one document per line
+	std::string NDJSON( size_t numLines )
+	{
+		std::string result;
+		for ( size_t i = 0; i < numLines; ++i )
+		{
+			result += "{\"seq\":" + std::to_string( i ) + ",\"level\":\"" + ( Next( 4 ) ? "info" : "warn" ) +
+			          "\",\"latency\":" + std::to_string( Next( 100000 ) / 100.0 ) + ",\"tags\":[\"a\",\"b\"]}\n";
+		}
+
+		return result;
+	}
+
+private:
+	size_t Next( size_t range ) { return std::uniform_int_distribution<size_t>( 0, range - 1 )( _rng ); }
+
+	std::mt19937_64 _rng{ 0x6a736f6e35ull };
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+class Bench
+{
+public:
+	explicit Bench( std::chrono::milliseconds minTime ) : _minTime( minTime ) { }
+
+	static constexpr uint64_t unlimited = uint64_t( -1 );
+
+	// Runs 'func' repeatedly for at least 'minTime' (and at least 3 times), records mean time per iteration.
+	// Allocations are counted on one iteration after warm up and checked against 'maxAllocations'. Only library
+	// allocations are counted (document buffers, builder stacks, comparison, filters, output), not those of user
+	// containers filled by reflection: "twitter reflect read" reports 2 allocations while it fills 5000 statuses.
+	void Run( const std::string &corpus, const std::string &operation, size_t bytes, const std::function<void()> &func,
+	          uint64_t maxAllocations = unlimited )
+	{
+		using clock = std::chrono::steady_clock;
+
+		func(); // Warm up
+
+		uint64_t allocations = 0;
+		{
+			json5::allocation_tracker tracker;
+			func();
+			allocations = tracker.total();
+		}
+
+		size_t iterations = 0;
+		auto start = clock::now();
+		auto elapsed = clock::duration();
+		do
+		{
+			func();
+			++iterations;
+			elapsed = clock::now() - start;
+		}
+		while ( elapsed < _minTime || iterations < 3 );
+
+		BenchResult r;
+		r.corpus = corpus;
+		r.operation = operation;
+		r.bytes = bytes;
+		r.iterations = iterations;
+		r.ms_per_iteration = std::chrono::duration<double, std::milli>( elapsed ).count() / double( iterations );
+		r.mb_per_s = double( bytes ) / ( r.ms_per_iteration / 1000.0 ) / 1e6;
+		r.allocations = allocations;
+		r.over_budget = allocations > maxAllocations;
+
+		printf( "%-10s %-36s %10.3f ms %10.1f MB/s %8llu allocs%s\n", corpus.c_str(), operation.c_str(), r.ms_per_iteration,
+		        r.mb_per_s, (unsigned long long)allocations, r.over_budget ? " OVER BUDGET" : "" );
+
+		_overBudget |= r.over_budget;
+		_report.results.push_back( std::move( r ) );
+	}
+
+	BenchReport &Report() noexcept { return _report; }
+
+	// Some operation allocated more than its budget
+	bool OverBudget() const noexcept { return _overBudget; }
+
+private:
+	std::chrono::milliseconds _minTime;
+	BenchReport _report;
+	bool _overBudget = false;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Library allocations allowed per iteration, with warmed up (reused) documents and output strings
+struct AllocationBudget
+{
+	uint64_t parse = Bench::unlimited;
+	uint64_t serialize = 0;
+	uint64_t equality = 0;
+	uint64_t filter = Bench::unlimited;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Parse, serialize, compare and filter one corpus
+void BenchDocument( Bench &bench, const std::string &corpus, const std::string &text, const char *pattern, const AllocationBudget &budget = {} )
+{
+	json5::document doc, doc2;
+	if ( auto err = json5::from_string( text, doc ) )
+	{
+		std::cout << corpus << ": " << json5::to_string( err ) << std::endl;
+		return;
+	}
+
+	json5::from_string( text, doc2 );
+
+	json5::writer_params wp;
+	wp.compact = true;
+	wp.json_compatible = true;
+
+	std::string out;
+	bench.Run( corpus, "parse", text.size(), [&]() { json5::from_string( text, doc ); }, budget.parse );
+	bench.Run( corpus, "serialize", text.size(), [&]() { json5::to_string( out, doc, wp ); }, budget.serialize );
+	bench.Run( corpus, "serialize (pretty)", text.size(), [&]() { json5::to_string( out, doc ); }, budget.serialize );
+	bench.Run( corpus, "equality", text.size(), [&]() { if ( !( doc == doc2 ) ) std::cout << corpus << ": doc != doc2" << std::endl; },
+	           budget.equality );
+
+	json5::compiled_filter filter( pattern );
+	size_t count = 0;
+	bench.Run( corpus, std::string( "filter " ) + pattern, text.size(), [&]() { count += json5::filter_count( doc, filter ); },
+	           budget.filter );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int main( int argc, char *argv[] )
+{
+	const char *outputFile = argc > 1 ? argv[1] : "bench_results.json5";
+	Bench bench( std::chrono::milliseconds( argc > 2 ? atoi( argv[2] ) : 300 ) );
+
+#if defined( __clang__ )
+	bench.Report().compiler = "clang " __clang_version__;
+#elif defined( __GNUC__ )
+	bench.Report().compiler = "gcc " __VERSION__;
+#elif defined( _MSC_VER )
+	bench.Report().compiler = "msvc " + std::to_string( _MSC_VER );
+#endif
+
+#if defined( NDEBUG )
+	bench.Report().build = "release";
+#else
+	bench.Report().build = "debug";
+#endif
+
+	CorpusGenerator gen;
+	auto twitter = gen.Twitter( 5000 );
+	auto canada = gen.Canada( 100000 );
+	auto deep = gen.Deep( 500, 200 );
+	auto wide = gen.Wide( 20000 );
+	auto ndjson = gen.NDJSON( 20000 );
+
+	// Writers keep the first 32 levels of nesting on the stack, objects with up to 256 keys are compared on the stack
+	BenchDocument( bench, "twitter", twitter, "statuses/*/user/screen_name" );
+	BenchDocument( bench, "canada", canada, "**" );
+	BenchDocument( bench, "deep", deep, "**/k", { .serialize = Bench::unlimited } );
+	BenchDocument( bench, "wide", wide, "key_19999", { .equality = 2 } );
+
+	// NDJSON, every line is a separate document
+	{
+		std::vector<std::string> lines;
+		for ( std::string_view rest = ndjson; !rest.empty(); )
+		{
+			size_t eol = rest.find( '\n' );
+			lines.emplace_back( rest.substr( 0, eol ) );
+			rest.remove_prefix( eol == std::string_view::npos ? rest.size() : eol + 1 );
+		}
+
+		json5::document doc;
+		bench.Run( "ndjson", "parse", ndjson.size(), [&]()
+		{
+			for ( const auto &line : lines )
+				json5::from_string( line, doc );
+		} );
+
+		std::vector<json5::document> docs( lines.size() );
+		for ( size_t i = 0; i < lines.size(); ++i )
+			json5::from_string( lines[i], docs[i] );
+
+		bench.Run( "ndjson", "serialize (parallel)", ndjson.size(), [&]() { json5::to_string_parallel( docs ); } );
+	}
+
+	// Batch loading, one small file per NDJSON line
+	{
+		auto dir = std::filesystem::temp_directory_path() / "json5_bench_files";
+		std::filesystem::create_directories( dir );
+
+		std::vector<std::filesystem::path> paths;
+		size_t bytes = 0;
+		for ( std::string_view rest = ndjson; !rest.empty() && paths.size() < 2000; )
+		{
+			size_t eol = rest.find( '\n' );
+			auto line = rest.substr( 0, eol );
+			rest.remove_prefix( eol == std::string_view::npos ? rest.size() : eol + 1 );
+
+			paths.push_back( dir / ( std::to_string( paths.size() ) + ".json" ) );
+			std::ofstream( paths.back(), std::ios::binary ) << line;
+			bytes += line.size();
+		}
+
+		bench.Run( "files", "from_file (serial)", bytes, [&]()
+		{
+			json5::document doc;
+			for ( const auto &path : paths )
+				json5::from_file( path.string(), doc );
+		} );
+
+		bench.Run( "files", "load_files", bytes, [&]() { json5::load_files( paths ); } );
+
+		std::error_code ec;
+		std::filesystem::remove_all( dir, ec );
+	}
+
+	// Reflected writes go straight to the output, unless JSON5_REFLECT_USE_DOCUMENT routes them through a document
+#if defined( JSON5_REFLECT_USE_DOCUMENT )
+	const uint64_t writeBudget = Bench::unlimited;
+#else
+	const uint64_t writeBudget = 0;
+#endif
+
+	// Reflection, direct text path (or through a document, when JSON5_REFLECT_USE_DOCUMENT is defined)
+	{
+		Timeline timeline;
+		if ( auto err = json5::from_string( twitter, timeline ) )
+			std::cout << "twitter: " << json5::to_string( err ) << std::endl;
+
+		std::string out;
+		bench.Run( "twitter", "reflect read", twitter.size(), [&]() { Timeline t; json5::from_string( twitter, t ); } );
+		bench.Run( "twitter", "reflect write", twitter.size(), [&]() { json5::to_string( out, timeline ); }, writeBudget );
+		bench.Run( "twitter", "reflect write statuses (parallel)", twitter.size(), [&]()
+		{
+			json5::to_string_parallel( out, timeline.statuses, json5::writer_params(), json5::parallel_params{ 0, 256 } );
+		} );
+	}
+
+	// Reflection, text vs. binary encoding of many small records
+	{
+		std::vector<Record> records( 50000 );
+		for ( size_t i = 0; i < records.size(); ++i )
+			records[i].id = int( i ) - 1000;
+
+		std::string text;
+		std::vector<uint8_t> binary;
+		json5::to_string( text, records );
+		json5::to_binary( binary, records );
+
+		// All rows report MB/s of text, so text and binary throughput compare like-for-like
+		printf( "records: %zu bytes of text, %zu bytes binary\n", text.size(), binary.size() );
+
+		std::vector<Record> out;
+		bench.Run( "records", "reflect write", text.size(), [&]() { json5::to_string( text, records ); }, writeBudget );
+		bench.Run( "records", "reflect read", text.size(), [&]() { json5::from_string( text, out ); } );
+		bench.Run( "records", "binary write", text.size(), [&]() { json5::to_binary( binary, records ); } );
+		bench.Run( "records", "binary read", text.size(), [&]() { json5::from_binary( binary, out ); } );
+	}
+
+	std::ofstream ofs( outputFile );
+	json5::to_stream( ofs, bench.Report() );
+	ofs.close();
+
+	if ( !ofs )
+	{
+		std::cout << "Failed to write " << outputFile << std::endl;
+		return 1;
+	}
+
+	std::cout << "Results written to " << outputFile << std::endl;
+
+	if ( bench.OverBudget() )
+	{
+		std::cout << "Allocation budget exceeded" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,2 @@
+#!/bin/sh
+premake5 gmake2
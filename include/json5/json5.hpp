@@ -1,9 +1,12 @@
 #pragma once
 
 #include "json5_base.hpp"
+#include "json5_instrument.hpp"
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -18,7 +21,7 @@ class value
 {
 public:
 	// Construct null value
-	value() noexcept = default;
+	value() noexcept : _data( type_null ) { }
 
 	// Construct null value
 	value( std::nullptr_t ) noexcept : _data( type_null ) { }
@@ -30,10 +33,11 @@ public:
 	value( int val ) noexcept : _double( val ) { }
 
 	// Construct number value from float (will be converted to double)
-	value( float val ) noexcept : _double( val ) { }
+	value( float val ) noexcept : value( double( val ) ) { }
 
-	// Construct number value from double
-	value( double val ) noexcept : _double( val ) { }
+	// Construct number value from double. Type and pointers are kept in NaN bit patterns, so any NaN
+	// (such as 0.0 / 0.0, which has the sign bit set on x86) is stored as the canonical quiet NaN.
+	value( double val ) noexcept : _double( ( val != val ) ? std::numeric_limits<double>::quiet_NaN() : val ) { }
 
 	// Return value type
 	value_type type() const noexcept;
@@ -45,7 +49,7 @@ public:
 	bool is_boolean() const noexcept { return _data == type_true || _data == type_false; }
 
 	// Checks, if value stores number. Use 'get' or 'try_get' for reading.
-	bool is_number() const noexcept { return ( _data & mask_nanbits ) != mask_nanbits; }
+	bool is_number() const noexcept { return ( _data & mask_nanbits ) != mask_nanbits || _data == value_negative_infinity; }
 
 	// Checks, if value stores string. Use 'get_c_str' for reading.
 	bool is_string() const noexcept { return ( _data & mask_type ) == type_string; }
@@ -106,6 +110,9 @@ protected:
 
 	void relink( const class document *prevDoc, const class document &doc ) noexcept;
 
+	// Turns string/array/object pointers into offsets into the buffers of 'doc'
+	void unlink( const class document &doc ) noexcept;
+
 	// NaN-boxed data
 	union
 	{
@@ -123,6 +130,9 @@ protected:
 	static constexpr uint64_t type_array   = 0xFFF4000000000000ull;
 	static constexpr uint64_t type_object  = 0xFFF6000000000000ull;
 
+	// -Infinity has all of 'mask_nanbits' set, but no type
+	static constexpr uint64_t value_negative_infinity = 0xFFF0000000000000ull;
+
 	// Stores lower 48bits of uint64 as payload
 	void payload( uint64_t p ) noexcept { _data = ( _data & ~mask_payload ) | p; }
 
@@ -201,7 +211,6 @@ public:
 		iterator( const value *p = nullptr ) noexcept : _pair( p ) { }
 		bool operator!=( const iterator &other ) const noexcept { return _pair != other._pair; }
 		bool operator==( const iterator &other ) const noexcept { return _pair == other._pair; }
-		bool operator!=( const iterator &other ) const noexcept { return _pair != other._pair; }
 		iterator &operator++() noexcept { _pair += 2; return *this; }
 		key_value_pair operator*() const noexcept { return key_value_pair( _pair[0].get_c_str(), _pair[1] ); }
 
@@ -289,7 +298,7 @@ inline value::value( value_type t, uint64_t data )
 //---------------------------------------------------------------------------------------------------------------------
 inline value_type value::type() const noexcept
 {
-	if ( ( _data & mask_nanbits ) != mask_nanbits )
+	if ( is_number() )
 		return value_type::number;
 
 	if ( ( _data & mask_type ) == type_object )
@@ -382,9 +391,21 @@ inline void value::relink( const class document *prevDoc, const class document &
 	}
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline void value::unlink( const class document &doc ) noexcept
+{
+	if ( is_string() )
+		payload( payload<const char *>() - doc._strings.data() );
+	else if ( is_object() || is_array() )
+		payload( payload<const value *>() - doc._values.data() );
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 inline void document::assign_copy( const document &copy )
 {
+	JSON5_INSTRUMENT_GROWTH( document, _strings );
+	JSON5_INSTRUMENT_GROWTH( document, _values );
+
 	_data = copy._data;
 	_strings = copy._strings;
 	_values = copy._values;
@@ -398,15 +419,24 @@ inline void document::assign_copy( const document &copy )
 //---------------------------------------------------------------------------------------------------------------------
 inline void document::assign_rvalue( document &&rValue ) noexcept
 {
-	_data = std::move( rValue._data );
+	// Short strings do not keep their address when moved, so pointers are turned into offsets first
+	for ( auto &v : rValue._values )
+		v.unlink( rValue );
+
+	rValue.unlink( rValue );
+
+	_data = rValue._data;
 	_strings = std::move( rValue._strings );
 	_values = std::move( rValue._values );
 
+	rValue._data = type_null;
+	rValue._strings.clear();
+	rValue._values.clear();
+
 	for ( auto &v : _values )
-		v.relink( &rValue, *this );
+		v.relink( nullptr, *this );
 
-	for ( auto &v : rValue._values )
-		v.relink( this, rValue );
+	relink( nullptr, *this );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -454,6 +484,12 @@ inline bool object_view::operator==( const object_view &other ) const noexcept
 	key_value_pair tempPairs2[stack_pair_count];
 	key_value_pair *pairs1 = _count <= stack_pair_count ? tempPairs1 : new key_value_pair[_count];
 	key_value_pair *pairs2 = _count <= stack_pair_count ? tempPairs2 : new key_value_pair[_count];
+
+	if ( _count > stack_pair_count )
+	{
+		JSON5_INSTRUMENT_ALLOCATION( compare, 2, 2 * _count * sizeof( key_value_pair ) );
+	}
+
 	{ size_t i = 0; for ( const auto kvp : *this ) pairs1[i++] = kvp; }
 	{ size_t i = 0; for ( const auto kvp : other ) pairs2[i++] = kvp; }
 
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 
 /*
 	Generates class serialization helper for specified type:
@@ -13,12 +17,12 @@
 */
 #define JSON5_CLASS(_Name, ...) \
 	template <> struct json5::detail::class_wrapper<_Name> { \
-		static constexpr const char* names = #__VA_ARGS__; \
+		static constexpr auto names = _JSON5_NAMES( __VA_ARGS__ ); \
 		inline static auto make_named_tuple(_Name &out) noexcept { \
-			return std::tuple( names, std::tie( _JSON5_CONCAT( _JSON5_PREFIX_OUT, ( __VA_ARGS__ ) ) ) ); \
+			return std::tuple( &names, std::tie( _JSON5_CONCAT( _JSON5_PREFIX_OUT, ( __VA_ARGS__ ) ) ) ); \
 		} \
 		inline static auto make_named_tuple( const _Name &in ) noexcept { \
-			return std::tuple( names, std::tie( _JSON5_CONCAT( _JSON5_PREFIX_IN, ( __VA_ARGS__ ) ) ) ); \
+			return std::tuple( &names, std::tie( _JSON5_CONCAT( _JSON5_PREFIX_IN, ( __VA_ARGS__ ) ) ) ); \
 		} \
 	};
 
@@ -35,16 +39,16 @@
 */
 #define JSON5_CLASS_INHERIT(_Name, _Base, ...) \
 	template <> struct json5::detail::class_wrapper<_Name> { \
-		static constexpr const char* names = #__VA_ARGS__; \
+		static constexpr auto names = _JSON5_NAMES( __VA_ARGS__ ); \
 		inline static auto make_named_tuple(_Name &out) noexcept { \
 			return std::tuple_cat( \
 			                       json5::detail::class_wrapper<_Base>::make_named_tuple(out), \
-			                       std::tuple(names, std::tie( _JSON5_CONCAT(_JSON5_PREFIX_OUT, (__VA_ARGS__)) ))); \
+			                       std::tuple(&names, std::tie( _JSON5_CONCAT(_JSON5_PREFIX_OUT, (__VA_ARGS__)) ))); \
 		} \
 		inline static auto make_named_tuple(const _Name &in) noexcept { \
 			return std::tuple_cat( \
 			                       json5::detail::class_wrapper<_Base>::make_named_tuple(in), \
-			                       std::tuple(names, std::tie( _JSON5_CONCAT(_JSON5_PREFIX_IN, (__VA_ARGS__)) ))); \
+			                       std::tuple(&names, std::tie( _JSON5_CONCAT(_JSON5_PREFIX_IN, (__VA_ARGS__)) ))); \
 		} \
 	};
 
@@ -60,9 +64,11 @@
 */
 #define JSON5_MEMBERS(...) \
 	inline auto make_named_tuple() noexcept { \
-		return std::tuple((const char*)#__VA_ARGS__, std::tie( __VA_ARGS__ )); } \
+		static constexpr auto names = _JSON5_NAMES( __VA_ARGS__ ); \
+		return std::tuple(&names, std::tie( __VA_ARGS__ )); } \
 	inline auto make_named_tuple() const noexcept { \
-		return std::tuple((const char*)#__VA_ARGS__, std::tie( __VA_ARGS__ )); }
+		static constexpr auto names = _JSON5_NAMES( __VA_ARGS__ ); \
+		return std::tuple(&names, std::tie( __VA_ARGS__ )); }
 
 /*
 	Generates members serialzation helper inside class with inheritance:
@@ -81,13 +87,15 @@
 */
 #define JSON5_MEMBERS_INHERIT(_Base, ...) \
 	inline auto make_named_tuple() noexcept { \
+		static constexpr auto names = _JSON5_NAMES( __VA_ARGS__ ); \
 		return std::tuple_cat( \
 		                       json5::detail::class_wrapper<_Base>::make_named_tuple(*this), \
-		                       std::tuple((const char*)#__VA_ARGS__, std::tie( __VA_ARGS__ ))); } \
+		                       std::tuple(&names, std::tie( __VA_ARGS__ ))); } \
 	inline auto make_named_tuple() const noexcept { \
+		static constexpr auto names = _JSON5_NAMES( __VA_ARGS__ ); \
 		return std::tuple_cat( \
 		                       json5::detail::class_wrapper<_Base>::make_named_tuple(*this), \
-		                       std::tuple((const char*)#__VA_ARGS__, std::tie( __VA_ARGS__ ))); } \
+		                       std::tuple(&names, std::tie( __VA_ARGS__ ))); } \
 
 /*
 	Generates enum wrapper:
@@ -101,8 +109,9 @@
 #define JSON5_ENUM(_Name, ...) \
 	template <> struct json5::detail::enum_table<_Name> : std::true_type { \
 		using enum _Name; \
-		static constexpr const char* names = #__VA_ARGS__; \
-		static constexpr const _Name values[] = { __VA_ARGS__ }; };
+		static constexpr auto names = _JSON5_NAMES( __VA_ARGS__ ); \
+		static constexpr const _Name values[] = { __VA_ARGS__ }; \
+		static constexpr auto index = json5::detail::make_enum_index( values ); };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -193,6 +202,180 @@ template <typename T> struct class_wrapper
 
 template <typename T> struct enum_table : std::false_type { };
 
+//---------------------------------------------------------------------------------------------------------------------
+// FNV-1a hash of a member or enum name
+constexpr uint32_t hash_name( std::string_view name ) noexcept
+{
+	uint32_t hash = 2166136261u;
+
+	for ( char ch : name )
+		hash = ( hash ^ uint8_t( ch ) ) * 16777619u;
+
+	return hash;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Names of reflected members or enum values, split at compile time from the stringified macro arguments
+template <size_t N>
+struct name_table
+{
+	std::array<std::string_view, N> names = { };
+	std::array<uint32_t, N> hashes = { };
+
+	// Hashes in ascending order and name indices they belong to
+	std::array<uint32_t, N> sorted_hashes = { };
+	std::array<size_t, N> sorted_indices = { };
+
+	static constexpr size_t npos = size_t( -1 );
+
+	static constexpr size_t size() noexcept { return N; }
+	constexpr std::string_view operator[]( size_t index ) const noexcept { return names[index]; }
+
+	// Find index of 'name', returns 'npos' when not found
+	constexpr size_t find( std::string_view name ) const noexcept
+	{
+		const uint32_t hash = hash_name( name );
+
+		size_t lo = 0, hi = N;
+		while ( lo < hi )
+		{
+			size_t mid = ( lo + hi ) / 2;
+			if ( sorted_hashes[mid] < hash )
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		for ( ; lo < N && sorted_hashes[lo] == hash; ++lo )
+		{
+			const auto &candidate = names[sorted_indices[lo]];
+			if ( candidate.size() == name.size() && candidate == name )
+				return sorted_indices[lo];
+		}
+
+		return npos;
+	}
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+constexpr size_t count_names( std::string_view names ) noexcept
+{
+	size_t result = names.empty() ? 0 : 1;
+
+	for ( char ch : names )
+		result += ( ch == ',' ) ? 1 : 0;
+
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Maps enum values to their position in the JSON5_ENUM list
+template <typename T, size_t N>
+struct enum_index
+{
+	using underlying = std::underlying_type_t<T>;
+	using unsigned_underlying = std::make_unsigned_t<underlying>;
+
+	// Values in ascending order and their positions in the list
+	std::array<underlying, N> sorted_values = { };
+	std::array<size_t, N> sorted_indices = { };
+
+	// Values are exactly [sorted_values[0], sorted_values[0] + N), so they can be used as index directly
+	bool dense = false;
+
+	static constexpr size_t npos = size_t( -1 );
+
+	// Find position of 'value', returns 'npos' when not found
+	constexpr size_t find( T value ) const noexcept
+	{
+		const auto v = underlying( value );
+
+		if ( dense )
+		{
+			if ( v < sorted_values[0] || size_t( unsigned_underlying( v ) - unsigned_underlying( sorted_values[0] ) ) >= N )
+				return npos;
+
+			return sorted_indices[size_t( unsigned_underlying( v ) - unsigned_underlying( sorted_values[0] ) )];
+		}
+
+		size_t lo = 0, hi = N;
+		while ( lo < hi )
+		{
+			size_t mid = ( lo + hi ) / 2;
+			if ( sorted_values[mid] < v )
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		return ( lo < N && sorted_values[lo] == v ) ? sorted_indices[lo] : npos;
+	}
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+constexpr enum_index<T, N> make_enum_index( const T( &values )[N] ) noexcept
+{
+	enum_index<T, N> result;
+
+	for ( size_t i = 0; i < N; ++i )
+	{
+		const auto v = std::underlying_type_t<T>( values[i] );
+
+		// Insertion sort by value
+		size_t j = i;
+		for ( ; j > 0 && result.sorted_values[j - 1] > v; --j )
+		{
+			result.sorted_values[j] = result.sorted_values[j - 1];
+			result.sorted_indices[j] = result.sorted_indices[j - 1];
+		}
+
+		result.sorted_values[j] = v;
+		result.sorted_indices[j] = i;
+	}
+
+	result.dense = true;
+	for ( size_t i = 1; i < N; ++i )
+		if ( result.sorted_values[i] != result.sorted_values[i - 1] + 1 )
+			result.dense = false;
+
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t N>
+constexpr name_table<N> make_name_table( std::string_view names ) noexcept
+{
+	name_table<N> result;
+
+	for ( size_t i = 0, pos = 0; i < N; ++i )
+	{
+		while ( pos < names.size() && ( names[pos] <= 32 || names[pos] == ',' ) )
+			++pos;
+
+		size_t length = 0;
+		while ( pos + length < names.size() && names[pos + length] > 32 && names[pos + length] != ',' )
+			++length;
+
+		result.names[i] = names.substr( pos, length );
+		result.hashes[i] = hash_name( result.names[i] );
+		pos += length;
+
+		// Insertion sort by hash
+		size_t j = i;
+		for ( ; j > 0 && result.sorted_hashes[j - 1] > result.hashes[i]; --j )
+		{
+			result.sorted_hashes[j] = result.sorted_hashes[j - 1];
+			result.sorted_indices[j] = result.sorted_indices[j - 1];
+		}
+
+		result.sorted_hashes[j] = result.hashes[i];
+		result.sorted_indices[j] = i;
+	}
+
+	return result;
+}
+
 class char_source
 {
 public:
@@ -219,12 +402,24 @@ protected:
 #define _JSON5_JOIN(X, Y) _JSON5_JOIN2(X, Y)
 #define _JSON5_JOIN2(X, Y) X##Y
 #define _JSON5_COUNT(...) _JSON5_EXPAND(_JSON5_COUNT2(__VA_ARGS__, \
-                                        16, 15, 14, 13, 12, 11, 10, 9, \
-                                        8, 7, 6, 5, 4, 3, 2, 1, ))
+                                        128, 127, 126, 125, 124, 123, 122, 121, 120, 119, 118, 117, 116, 115, 114, 113, \
+                                        112, 111, 110, 109, 108, 107, 106, 105, 104, 103, 102, 101, 100, 99, 98, 97, \
+                                        96, 95, 94, 93, 92, 91, 90, 89, 88, 87, 86, 85, 84, 83, 82, 81, \
+                                        80, 79, 78, 77, 76, 75, 74, 73, 72, 71, 70, 69, 68, 67, 66, 65, \
+                                        64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, \
+                                        48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, \
+                                        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, \
+                                        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, ))
 
 #define _JSON5_COUNT2(_, \
-                      _16, _15, _14, _13, _12, _11, _10, _9, \
-                      _8, _7, _6, _5, _4, _3, _2, _X, ...) _X
+                      _128, _127, _126, _125, _124, _123, _122, _121, _120, _119, _118, _117, _116, _115, _114, _113, \
+                      _112, _111, _110, _109, _108, _107, _106, _105, _104, _103, _102, _101, _100, _99, _98, _97, \
+                      _96, _95, _94, _93, _92, _91, _90, _89, _88, _87, _86, _85, _84, _83, _82, _81, \
+                      _80, _79, _78, _77, _76, _75, _74, _73, _72, _71, _70, _69, _68, _67, _66, _65, \
+                      _64, _63, _62, _61, _60, _59, _58, _57, _56, _55, _54, _53, _52, _51, _50, _49, \
+                      _48, _47, _46, _45, _44, _43, _42, _41, _40, _39, _38, _37, _36, _35, _34, _33, \
+                      _32, _31, _30, _29, _28, _27, _26, _25, _24, _23, _22, _21, _20, _19, _18, _17, \
+                      _16, _15, _14, _13, _12, _11, _10, _9, _8, _7, _6, _5, _4, _3, _2, _X, ...) _X
 
 #define _JSON5_FIRST(...) _JSON5_EXPAND(_JSON5_FIRST2(__VA_ARGS__, ))
 #define _JSON5_FIRST2(X,...) X
@@ -248,6 +443,120 @@ protected:
 #define _JSON5_CONCAT_14(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_13(_Prefix,_JSON5_TAIL _Args)
 #define _JSON5_CONCAT_15(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_14(_Prefix,_JSON5_TAIL _Args)
 #define _JSON5_CONCAT_16(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_15(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_17(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_16(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_18(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_17(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_19(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_18(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_20(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_19(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_21(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_20(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_22(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_21(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_23(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_22(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_24(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_23(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_25(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_24(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_26(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_25(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_27(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_26(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_28(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_27(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_29(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_28(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_30(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_29(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_31(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_30(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_32(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_31(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_33(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_32(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_34(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_33(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_35(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_34(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_36(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_35(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_37(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_36(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_38(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_37(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_39(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_38(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_40(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_39(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_41(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_40(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_42(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_41(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_43(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_42(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_44(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_43(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_45(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_44(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_46(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_45(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_47(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_46(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_48(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_47(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_49(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_48(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_50(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_49(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_51(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_50(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_52(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_51(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_53(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_52(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_54(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_53(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_55(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_54(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_56(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_55(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_57(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_56(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_58(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_57(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_59(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_58(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_60(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_59(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_61(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_60(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_62(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_61(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_63(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_62(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_64(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_63(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_65(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_64(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_66(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_65(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_67(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_66(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_68(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_67(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_69(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_68(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_70(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_69(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_71(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_70(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_72(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_71(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_73(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_72(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_74(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_73(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_75(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_74(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_76(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_75(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_77(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_76(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_78(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_77(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_79(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_78(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_80(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_79(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_81(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_80(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_82(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_81(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_83(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_82(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_84(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_83(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_85(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_84(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_86(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_85(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_87(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_86(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_88(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_87(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_89(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_88(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_90(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_89(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_91(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_90(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_92(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_91(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_93(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_92(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_94(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_93(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_95(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_94(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_96(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_95(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_97(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_96(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_98(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_97(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_99(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_98(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_100(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_99(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_101(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_100(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_102(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_101(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_103(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_102(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_104(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_103(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_105(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_104(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_106(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_105(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_107(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_106(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_108(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_107(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_109(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_108(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_110(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_109(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_111(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_110(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_112(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_111(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_113(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_112(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_114(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_113(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_115(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_114(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_116(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_115(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_117(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_116(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_118(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_117(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_119(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_118(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_120(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_119(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_121(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_120(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_122(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_121(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_123(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_122(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_124(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_123(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_125(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_124(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_126(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_125(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_127(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_126(_Prefix,_JSON5_TAIL _Args)
+#define _JSON5_CONCAT_128(_Prefix, _Args) _Prefix(_JSON5_FIRST _Args),_JSON5_CONCAT_127(_Prefix,_JSON5_TAIL _Args)
 
 #define _JSON5_PREFIX_IN(_X) in. _X
 #define _JSON5_PREFIX_OUT(_X) out. _X
+
+#define _JSON5_NAMES(...) json5::detail::make_name_table<json5::detail::count_names( #__VA_ARGS__ )>( #__VA_ARGS__ )
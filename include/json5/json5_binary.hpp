@@ -0,0 +1,732 @@
+#pragma once
+
+#include "json5_reflect.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+/*
+	Compact binary encoding of reflected types, driven by the same JSON5_MEMBERS/JSON5_CLASS/JSON5_ENUM metadata
+	as the text format. There are no key strings and no document, both sides must agree on the types.
+
+	- bool, integers and enums are varints (signed ones zigzag encoded)
+	- float and double are stored as little endian 4 and 8 bytes
+	- strings are a varint byte length followed by UTF-8 bytes
+	- arrays and maps are a 32-bit little endian byte length, a varint item count and the items
+	- reflected types are a 32-bit byte length followed by fields, each a varint tag (member index << 3 | wire type)
+	  followed by the value. Members are numbered in declaration order, base class members first.
+	  Unknown fields are skipped, so members can be appended without breaking older readers.
+
+	Errors report the byte offset in 'column'.
+*/
+
+namespace json5 {
+
+//
+template <typename T> void to_binary( std::vector<uint8_t> &out, const T &in );
+
+//
+template <typename T> std::vector<uint8_t> to_binary( const T &in );
+
+// 'std::string_view' members of 'out' point into 'data'
+template <typename T> error from_binary( const void *data, size_t size, T &out );
+
+//
+template <typename T> error from_binary( const std::vector<uint8_t> &data, T &out );
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+//---------------------------------------------------------------------------------------------------------------------
+enum class wire_type : uint8_t
+{
+	varint = 0,
+	fixed64 = 1,
+	bytes = 2,
+	composite = 3,
+	fixed32 = 5,
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+constexpr bool is_binary_string_v = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> || std::is_same_v<T, const char *>;
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+constexpr wire_type binary_wire_type() noexcept
+{
+	if constexpr ( std::is_same_v<T, float> )
+		return wire_type::fixed32;
+	else if constexpr ( std::is_floating_point_v<T> )
+		return wire_type::fixed64;
+	else if constexpr ( std::is_arithmetic_v<T> || std::is_enum_v<T> )
+		return wire_type::varint;
+	else if constexpr ( is_binary_string_v<T> )
+		return wire_type::bytes;
+	else
+		return wire_type::composite;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename = void> struct has_mapped_type : std::false_type { };
+template <typename T> struct has_mapped_type<T, std::void_t<typename T::mapped_type>> : std::true_type { };
+
+//---------------------------------------------------------------------------------------------------------------------
+// Error reported when a field has a different wire type than member of type 'T'
+template <typename T>
+constexpr int binary_type_error() noexcept
+{
+	if constexpr ( std::is_same_v<T, bool> )
+		return error::boolean_expected;
+	else if constexpr ( std::is_arithmetic_v<T> || std::is_enum_v<T> )
+		return error::number_expected;
+	else if constexpr ( is_binary_string_v<T> )
+		return error::string_expected;
+	else if constexpr ( is_reflected_v<T> || has_mapped_type<T>::value )
+		return error::object_expected;
+	else
+		return error::array_expected;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Floating point arrays are copied as a whole on little endian hosts
+template <typename T>
+constexpr bool is_binary_bulk_v = ( std::is_same_v<T, float> || std::is_same_v<T, double> ) && std::endian::native == std::endian::little;
+
+//---------------------------------------------------------------------------------------------------------------------
+class binary_writer final
+{
+public:
+	binary_writer( std::vector<uint8_t> &out ) : _out( out ) { }
+
+	void varint( uint64_t v )
+	{
+		while ( v >= 0x80 )
+		{
+			_out.push_back( uint8_t( v ) | 0x80 );
+			v >>= 7;
+		}
+
+		_out.push_back( uint8_t( v ) );
+	}
+
+	template <typename T>
+	void fixed( T v )
+	{
+		uint8_t bytes[sizeof( T )];
+		memcpy( bytes, &v, sizeof( T ) );
+
+		if constexpr ( std::endian::native != std::endian::little )
+			std::reverse( bytes, bytes + sizeof( T ) );
+
+		_out.insert( _out.end(), bytes, bytes + sizeof( T ) );
+	}
+
+	void bytes( const void *data, size_t size )
+	{
+		auto *p = static_cast<const uint8_t *>( data );
+		_out.insert( _out.end(), p, p + size );
+	}
+
+	void tag( size_t index, wire_type wt ) { varint( ( uint64_t( index ) << 3 ) | uint64_t( wt ) ); }
+
+	// Reserves room for the byte length of a composite value, returns position to pass to 'end_composite'
+	size_t begin_composite()
+	{
+		size_t pos = _out.size();
+		_out.resize( pos + sizeof( uint32_t ) );
+		return pos;
+	}
+
+	void end_composite( size_t pos )
+	{
+		uint32_t size = uint32_t( _out.size() - pos - sizeof( uint32_t ) );
+		for ( size_t i = 0; i < sizeof( uint32_t ); ++i )
+			_out[pos + i] = uint8_t( size >> ( i * 8 ) );
+	}
+
+private:
+	std::vector<uint8_t> &_out;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+class binary_reader final
+{
+public:
+	binary_reader( const uint8_t *data, size_t size ) : _begin( data ), _cursor( data ), _end( data + size ) { }
+
+	const uint8_t *position() const noexcept { return _cursor; }
+	const uint8_t *end() const noexcept { return _end; }
+
+	error make_error( int type ) const noexcept { return error{ type, 0, int( _cursor - _begin ) }; }
+
+	error varint( uint64_t &out )
+	{
+		out = 0;
+		for ( int shift = 0; shift < 64; shift += 7 )
+		{
+			if ( _cursor == _end )
+				return make_error( error::unexpected_end );
+
+			uint8_t byte = *_cursor++;
+			out |= uint64_t( byte & 0x7F ) << shift;
+
+			if ( !( byte & 0x80 ) )
+				return { error::none };
+		}
+
+		return make_error( error::syntax_error );
+	}
+
+	template <typename T>
+	error fixed( T &out )
+	{
+		uint8_t bytes[sizeof( T )];
+		if ( auto err = read_bytes( bytes, sizeof( T ) ) )
+			return err;
+
+		if constexpr ( std::endian::native != std::endian::little )
+			std::reverse( bytes, bytes + sizeof( T ) );
+
+		memcpy( &out, bytes, sizeof( T ) );
+		return { error::none };
+	}
+
+	error read_bytes( void *out, size_t size )
+	{
+		const uint8_t *data = nullptr;
+		if ( auto err = bytes( size, data ) )
+			return err;
+
+		memcpy( out, data, size );
+		return { error::none };
+	}
+
+	error bytes( size_t size, const uint8_t *&out )
+	{
+		if ( size_t( _end - _cursor ) < size )
+			return make_error( error::unexpected_end );
+
+		out = _cursor;
+		_cursor += size;
+		return { error::none };
+	}
+
+	// Reads byte length of a composite value, 'end' is set past its last byte
+	error begin_composite( const uint8_t *&end )
+	{
+		uint32_t size = 0;
+		if ( auto err = fixed( size ) )
+			return err;
+
+		if ( size_t( _end - _cursor ) < size )
+			return make_error( error::unexpected_end );
+
+		end = _cursor + size;
+		return { error::none };
+	}
+
+	error end_composite( const uint8_t *end )
+	{
+		return ( _cursor == end ) ? error() : make_error( error::syntax_error );
+	}
+
+	error skip( wire_type wt )
+	{
+		uint64_t size = 0;
+		const uint8_t *data = nullptr;
+
+		switch ( wt )
+		{
+			case wire_type::varint: return varint( size );
+			case wire_type::fixed64: return bytes( 8, data );
+			case wire_type::fixed32: return bytes( 4, data );
+			case wire_type::bytes:
+				if ( auto err = varint( size ) )
+					return err;
+
+				return bytes( size_t( size ), data );
+
+			case wire_type::composite:
+				if ( auto err = begin_composite( data ) )
+					return err;
+
+				_cursor = data;
+				return { error::none };
+		}
+
+		return make_error( error::syntax_error );
+	}
+
+private:
+	const uint8_t *_begin = nullptr;
+	const uint8_t *_cursor = nullptr;
+	const uint8_t *_end = nullptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Forward declarations */
+template <typename T> void write( binary_writer &w, const T &in );
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void write( binary_writer &w, std::string_view in )
+{
+	w.varint( in.size() );
+	w.bytes( in.data(), in.size() );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void write( binary_writer &w, const char *in ) { write( w, std::string_view( in ) ); }
+inline void write( binary_writer &w, const std::string &in ) { write( w, std::string_view( in ) ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void write_array( binary_writer &w, const T *in, size_t numItems )
+{
+	size_t pos = w.begin_composite();
+	w.varint( numItems );
+
+	if constexpr ( is_binary_bulk_v<T> )
+		w.bytes( in, numItems * sizeof( T ) );
+	else
+	{
+		for ( size_t i = 0; i < numItems; ++i )
+			write( w, in[i] );
+	}
+
+	w.end_composite( pos );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename A>
+inline void write( binary_writer &w, const std::vector<T, A> &in ) { write_array( w, in.data(), in.size() ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+// std::vector<bool> has no contiguous bool storage, items are written one by one
+template <typename A>
+inline void write( binary_writer &w, const std::vector<bool, A> &in )
+{
+	size_t pos = w.begin_composite();
+	w.varint( in.size() );
+
+	for ( bool item : in )
+		write( w, item );
+
+	w.end_composite( pos );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline void write( binary_writer &w, const T( &in )[N] ) { write_array( w, in, N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline void write( binary_writer &w, const std::array<T, N> &in ) { write_array( w, in.data(), N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void write_map( binary_writer &w, const T &in )
+{
+	size_t pos = w.begin_composite();
+	w.varint( in.size() );
+
+	for ( const auto &kvp : in )
+	{
+		write( w, kvp.first );
+		write( w, kvp.second );
+	}
+
+	w.end_composite( pos );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename K, typename T, typename P, typename A>
+inline void write( binary_writer &w, const std::map<K, T, P, A> &in ) { write_map( w, in ); }
+
+template <typename K, typename T, typename H, typename EQ, typename A>
+inline void write( binary_writer &w, const std::unordered_map<K, T, H, EQ, A> &in ) { write_map( w, in ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t N, typename... Types, size_t... Is>
+inline void write_tuple( binary_writer &w, size_t index, const name_table<N> &names, const std::tuple<Types...> &t, std::index_sequence<Is...> )
+{
+	( ( names[Is].empty() || ( w.tag( index + Is, binary_wire_type<std::decay_t<Types>>() ), write( w, std::get<Is>( t ) ), true ) ), ... );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t Index = 0, typename... Types>
+inline void write_named_tuple( binary_writer &w, size_t index, const std::tuple<Types...> &t )
+{
+	const auto &members = std::get < Index + 1 > ( t );
+	constexpr size_t numMembers = std::tuple_size_v<std::remove_reference_t<decltype( members )>>;
+
+	write_tuple( w, index, *std::get<Index>( t ), members, std::make_index_sequence<numMembers>() );
+
+	if constexpr ( Index + 2 != sizeof...( Types ) )
+		write_named_tuple < Index + 2 > ( w, index + numMembers, t );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void write( binary_writer &w, const T &in )
+{
+	if constexpr ( std::is_enum_v<T> )
+		write( w, std::underlying_type_t<T>( in ) );
+	else if constexpr ( std::is_same_v<T, float> )
+		w.fixed( in );
+	else if constexpr ( std::is_floating_point_v<T> )
+		w.fixed( double( in ) );
+	else if constexpr ( std::is_signed_v<T> )
+		w.varint( ( uint64_t( int64_t( in ) ) << 1 ) ^ uint64_t( int64_t( in ) >> 63 ) );
+	else if constexpr ( std::is_arithmetic_v<T> )
+		w.varint( uint64_t( in ) );
+	else
+	{
+		size_t pos = w.begin_composite();
+		write_named_tuple( w, 0, class_wrapper<T>::make_named_tuple( in ) );
+		w.end_composite( pos );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Forward declarations */
+template <typename T> error read( binary_reader &r, T &out );
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error read( binary_reader &r, std::string_view &out )
+{
+	uint64_t size = 0;
+	const uint8_t *data = nullptr;
+
+	if ( auto err = r.varint( size ) )
+		return err;
+
+	if ( auto err = r.bytes( size_t( size ), data ) )
+		return err;
+
+	out = std::string_view( reinterpret_cast<const char *>( data ), size_t( size ) );
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error read( binary_reader &r, std::string &out )
+{
+	std::string_view str;
+	if ( auto err = read( r, str ) )
+		return err;
+
+	out = str;
+	return { error::none };
+}
+
+// Strings in the binary form are not null terminated, use std::string or std::string_view
+error read( binary_reader &r, const char *&out ) = delete;
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_items( binary_reader &r, T *out, size_t numItems )
+{
+	if constexpr ( is_binary_bulk_v<T> )
+		return r.read_bytes( out, numItems * sizeof( T ) );
+	else
+	{
+		for ( size_t i = 0; i < numItems; ++i )
+			if ( auto err = read( r, out[i] ) )
+				return err;
+
+		return { error::none };
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_array( binary_reader &r, T *out, size_t numItems )
+{
+	const uint8_t *end = nullptr;
+	uint64_t count = 0;
+
+	if ( auto err = r.begin_composite( end ) )
+		return err;
+
+	if ( auto err = r.varint( count ) )
+		return err;
+
+	if ( count != numItems )
+		return r.make_error( error::wrong_array_size );
+
+	if ( auto err = read_items( r, out, numItems ) )
+		return err;
+
+	return r.end_composite( end );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline error read( binary_reader &r, T( &out )[N] ) { return read_array( r, out, N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline error read( binary_reader &r, std::array<T, N> &out ) { return read_array( r, out.data(), N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename A>
+inline error read( binary_reader &r, std::vector<T, A> &out )
+{
+	const uint8_t *end = nullptr;
+	uint64_t count = 0;
+
+	if ( auto err = r.begin_composite( end ) )
+		return err;
+
+	if ( auto err = r.varint( count ) )
+		return err;
+
+	// Every item takes at least one byte, don't trust larger counts
+	if ( count > uint64_t( end - r.position() ) )
+		return r.make_error( error::unexpected_end );
+
+	out.clear();
+
+	if constexpr ( is_binary_bulk_v<T> )
+	{
+		out.resize( size_t( count ) );
+		if ( auto err = read_items( r, out.data(), out.size() ) )
+			return err;
+	}
+	else
+	{
+		out.reserve( size_t( count ) );
+		for ( uint64_t i = 0; i < count; ++i )
+			if ( auto err = read( r, out.emplace_back() ) )
+				return err;
+	}
+
+	return r.end_composite( end );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename A>
+inline error read( binary_reader &r, std::vector<bool, A> &out )
+{
+	const uint8_t *end = nullptr;
+	uint64_t count = 0;
+
+	if ( auto err = r.begin_composite( end ) )
+		return err;
+
+	if ( auto err = r.varint( count ) )
+		return err;
+
+	if ( count > uint64_t( end - r.position() ) )
+		return r.make_error( error::unexpected_end );
+
+	out.clear();
+	out.reserve( size_t( count ) );
+
+	for ( uint64_t i = 0; i < count; ++i )
+	{
+		bool item = false;
+		if ( auto err = read( r, item ) )
+			return err;
+
+		out.push_back( item );
+	}
+
+	return r.end_composite( end );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_map( binary_reader &r, T &out )
+{
+	const uint8_t *end = nullptr;
+	uint64_t count = 0;
+
+	if ( auto err = r.begin_composite( end ) )
+		return err;
+
+	if ( auto err = r.varint( count ) )
+		return err;
+
+	out.clear();
+	for ( uint64_t i = 0; i < count; ++i )
+	{
+		std::pair<typename T::key_type, typename T::mapped_type> kvp;
+
+		if ( auto err = read( r, kvp.first ) )
+			return err;
+
+		if ( auto err = read( r, kvp.second ) )
+			return err;
+
+		out.emplace( std::move( kvp ) );
+	}
+
+	return r.end_composite( end );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename K, typename T, typename P, typename A>
+inline error read( binary_reader &r, std::map<K, T, P, A> &out ) { return read_map( r, out ); }
+
+template <typename K, typename T, typename H, typename EQ, typename A>
+inline error read( binary_reader &r, std::unordered_map<K, T, H, EQ, A> &out ) { return read_map( r, out ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t Index, typename Tuple>
+inline error read_binary_member( binary_reader &r, wire_type wt, Tuple &t )
+{
+	using member_type = std::decay_t<std::tuple_element_t<Index, Tuple>>;
+
+	if ( wt != binary_wire_type<member_type>() )
+		return r.make_error( binary_type_error<member_type>() );
+
+	return read( r, std::get<Index>( t ) );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Read tuple item selected by runtime 'index' through a table of per-member read functions
+template <typename Tuple, size_t... Is>
+inline error read_binary_member( binary_reader &r, size_t index, wire_type wt, Tuple &t, std::index_sequence<Is...> )
+{
+	using read_func = error( * )( binary_reader &, wire_type, Tuple & );
+	static constexpr read_func table[] = { &read_binary_member<Is, Tuple>... };
+	return table[index]( r, wt, t );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Find member with flattened 'index' (base class members first) and read it, sets 'found' on success
+template <size_t Index = 0, typename Tuple>
+inline error read_binary_field( binary_reader &r, size_t index, wire_type wt, Tuple &t, bool &found )
+{
+	auto &members = std::get < Index + 1 > ( t );
+	constexpr size_t numMembers = std::tuple_size_v<std::remove_reference_t<decltype( members )>>;
+
+	if ( index < numMembers )
+	{
+		found = !( *std::get<Index>( t ) )[index].empty();
+		return found ? read_binary_member( r, index, wt, members, std::make_index_sequence<numMembers>() ) : error();
+	}
+
+	if constexpr ( Index + 2 != std::tuple_size_v<Tuple> )
+		return read_binary_field < Index + 2 > ( r, index - numMembers, wt, t, found );
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read( binary_reader &r, T &out )
+{
+	if constexpr ( std::is_enum_v<T> )
+	{
+		std::underlying_type_t<T> temp;
+		if ( auto err = read( r, temp ) )
+			return err;
+
+		out = T( temp );
+		return { error::none };
+	}
+	else if constexpr ( std::is_same_v<T, float> )
+		return r.fixed( out );
+	else if constexpr ( std::is_floating_point_v<T> )
+	{
+		double temp = 0.0;
+		if ( auto err = r.fixed( temp ) )
+			return err;
+
+		out = T( temp );
+		return { error::none };
+	}
+	else if constexpr ( std::is_arithmetic_v<T> )
+	{
+		uint64_t temp = 0;
+		if ( auto err = r.varint( temp ) )
+			return err;
+
+		if constexpr ( std::is_same_v<T, bool> )
+			out = temp != 0;
+		else if constexpr ( std::is_signed_v<T> )
+			out = T( int64_t( temp >> 1 ) ^ -int64_t( temp & 1 ) );
+		else
+			out = T( temp );
+
+		return { error::none };
+	}
+	else
+	{
+		const uint8_t *end = nullptr;
+		if ( auto err = r.begin_composite( end ) )
+			return err;
+
+		auto namedTuple = class_wrapper<T>::make_named_tuple( out );
+
+		while ( r.position() < end )
+		{
+			uint64_t tag = 0;
+			if ( auto err = r.varint( tag ) )
+				return err;
+
+			auto wt = wire_type( tag & 7 );
+			bool found = false;
+
+			if ( auto err = read_binary_field( r, size_t( tag >> 3 ), wt, namedTuple, found ) )
+				return err;
+
+			// Unknown fields are skipped
+			if ( !found )
+				if ( auto err = r.skip( wt ) )
+					return err;
+		}
+
+		return r.end_composite( end );
+	}
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void to_binary( std::vector<uint8_t> &out, const T &in )
+{
+	out.clear();
+	detail::binary_writer w( out );
+	detail::write( w, in );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline std::vector<uint8_t> to_binary( const T &in )
+{
+	std::vector<uint8_t> result;
+	to_binary( result, in );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error from_binary( const void *data, size_t size, T &out )
+{
+	detail::binary_reader r( static_cast<const uint8_t *>( data ), size );
+	if ( auto err = detail::read( r, out ) )
+		return err;
+
+	return ( r.position() == r.end() ) ? error() : r.make_error( error::syntax_error );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error from_binary( const std::vector<uint8_t> &data, T &out )
+{
+	return from_binary( data.data(), data.size(), out );
+}
+
+} // namespace json5
@@ -4,11 +4,48 @@
 
 namespace json5 {
 
+namespace detail {
+
+// Append UTF-8 encoded character to string
+void append_utf8( std::string &s, uint32_t ch );
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Scratch buffers of a builder or parser, kept between uses. Repeated parsing with the same context does not
+	allocate once the buffers have grown. A context can be used by one builder at a time, keep one per thread.
+*/
+class parse_context final
+{
+public:
+	// Buffer for file contents which can not be memory mapped
+	std::string &file_buffer() noexcept { return _fileBuffer; }
+
+private:
+	friend class builder;
+
+	std::vector<value> _stack;
+	std::vector<value> _values;
+	std::vector<size_t> _counts;
+	std::string _fileBuffer;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 class builder
 {
 public:
 	builder( document &doc ) : _doc( doc ) { }
 
+	// Builder borrowing scratch buffers of 'context' until destroyed
+	builder( document &doc, parse_context &context );
+	~builder();
+
+	builder( const builder & ) = delete;
+	builder &operator=( const builder & ) = delete;
+
 	const document &doc() const noexcept { return _doc; }
 
 	detail::string_offset string_buffer_offset() const noexcept;
@@ -29,15 +66,43 @@ public:
 
 protected:
 	void reset() noexcept;
+	std::string &string_buffer() noexcept { return _doc._strings; }
 
 	document &_doc;
 	std::vector<value> _stack;
 	std::vector<value> _values;
 	std::vector<size_t> _counts;
+	parse_context *_context = nullptr;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+//---------------------------------------------------------------------------------------------------------------------
+inline builder::builder( document &doc, parse_context &context )
+	: _doc( doc )
+	, _context( &context )
+{
+	_stack.swap( context._stack );
+	_values.swap( context._values );
+	_counts.swap( context._counts );
+
+	// Left over from a failed parse
+	_stack.clear();
+	_values.clear();
+	_counts.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline builder::~builder()
+{
+	if ( _context )
+	{
+		_stack.swap( _context->_stack );
+		_values.swap( _context->_values );
+		_counts.swap( _context->_counts );
+	}
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 inline detail::string_offset builder::string_buffer_offset() const noexcept
 {
@@ -47,6 +112,8 @@ inline detail::string_offset builder::string_buffer_offset() const noexcept
 //---------------------------------------------------------------------------------------------------------------------
 inline detail::string_offset builder::string_buffer_add( std::string_view str )
 {
+	JSON5_INSTRUMENT_GROWTH( document, _doc._strings );
+
 	auto offset = string_buffer_offset();
 	_doc._strings += str;
 	_doc._strings.push_back( 0 );
@@ -54,10 +121,8 @@ inline detail::string_offset builder::string_buffer_add( std::string_view str )
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline void builder::string_buffer_add_utf8( uint32_t ch )
+inline void detail::append_utf8( std::string &s, uint32_t ch )
 {
-	auto &s = _doc._strings;
-
 	if ( 0 <= ch && ch <= 0x7f )
 	{
 		s += char( ch );
@@ -99,25 +164,42 @@ inline void builder::string_buffer_add_utf8( uint32_t ch )
 	}
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline void builder::string_buffer_add_utf8( uint32_t ch )
+{
+	detail::append_utf8( _doc._strings, ch );
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 inline void builder::push_object()
 {
+	JSON5_INSTRUMENT_GROWTH( builder, _stack );
+	JSON5_INSTRUMENT_GROWTH( builder, _counts );
+
 	auto v = value( value_type::object, nullptr );
 	_stack.emplace_back( v );
 	_counts.push_back( 0 );
+	JSON5_INSTRUMENT_DEPTH( _stack.size() );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 inline void builder::push_array()
 {
+	JSON5_INSTRUMENT_GROWTH( builder, _stack );
+	JSON5_INSTRUMENT_GROWTH( builder, _counts );
+
 	auto v = value( value_type::array, nullptr );
 	_stack.emplace_back( v );
 	_counts.push_back( 0 );
+	JSON5_INSTRUMENT_DEPTH( _stack.size() );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 inline value builder::pop()
 {
+	JSON5_INSTRUMENT_PHASE( relink );
+	JSON5_INSTRUMENT_GROWTH( document, _doc._values );
+
 	auto result = _stack.back();
 	auto count = _counts.back();
 
@@ -146,6 +228,8 @@ inline value builder::pop()
 //---------------------------------------------------------------------------------------------------------------------
 inline builder &builder::operator+=( value v )
 {
+	JSON5_INSTRUMENT_GROWTH( builder, _values );
+
 	_values.push_back( v );
 	_counts.back() += 1;
 	return *this;
@@ -154,6 +238,8 @@ inline builder &builder::operator+=( value v )
 //---------------------------------------------------------------------------------------------------------------------
 inline value &builder::operator[]( detail::string_offset keyOffset )
 {
+	JSON5_INSTRUMENT_GROWTH( builder, _values );
+
 	_values.push_back( new_string( keyOffset ) );
 	_counts.back() += 2;
 	return _values.emplace_back();
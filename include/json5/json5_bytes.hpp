@@ -0,0 +1,151 @@
+#pragma once
+
+#include "json5_base.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace json5::detail {
+
+/*
+	Output of binary encoders. Appends to a byte vector, or buffers bytes and writes them to a stream
+	in chunks of at least 'flush_size' bytes.
+*/
+class byte_sink final
+{
+public:
+	byte_sink( std::vector<uint8_t> &out ) : _out( out ) { }
+	byte_sink( std::ostream &os ) : _out( _buffer ), _os( &os ) { _buffer.reserve( flush_size * 2 ); }
+	~byte_sink() { flush(); }
+
+	byte_sink( const byte_sink & ) = delete;
+	byte_sink &operator=( const byte_sink & ) = delete;
+
+	void put( uint8_t byte ) { _out.push_back( byte ); }
+	void put( const void *data, size_t size ) { auto *p = static_cast<const uint8_t *>( data ); _out.insert( _out.end(), p, p + size ); }
+
+	// Write unsigned integer or floating point value as big endian
+	template <typename T>
+	void put_be( T v )
+	{
+		uint8_t bytes[sizeof( T )];
+		memcpy( bytes, &v, sizeof( T ) );
+
+		if constexpr ( std::endian::native == std::endian::little )
+			std::reverse( bytes, bytes + sizeof( T ) );
+
+		put( bytes, sizeof( T ) );
+	}
+
+	// Make room for at least 'size' more bytes
+	void reserve( size_t size ) { _out.reserve( _out.size() + size ); }
+
+	// Called between values, passes buffered bytes to the stream once enough of them have accumulated
+	void flush_if_needed() { if ( _os && _out.size() >= flush_size ) flush(); }
+
+	void flush()
+	{
+		if ( _os && !_out.empty() )
+		{
+			_os->write( reinterpret_cast<const char *>( _out.data() ), std::streamsize( _out.size() ) );
+			_out.clear();
+		}
+	}
+
+private:
+	static constexpr size_t flush_size = 16 * 1024;
+
+	std::vector<uint8_t> _buffer;
+	std::vector<uint8_t> &_out;
+	std::ostream *_os = nullptr;
+};
+
+/*
+	Bounds checked input of binary decoders. Errors report the byte offset in 'column'.
+*/
+class byte_source final
+{
+public:
+	byte_source( const void *data, size_t size )
+		: _begin( static_cast<const uint8_t *>( data ) ), _cursor( _begin ), _end( _begin + size ) { }
+
+	bool eof() const noexcept { return _cursor == _end; }
+	size_t remaining() const noexcept { return size_t( _end - _cursor ); }
+
+	error make_error( int type ) const noexcept { return error{ type, 0, int( _cursor - _begin ) }; }
+
+	error get( uint8_t &out )
+	{
+		if ( eof() )
+			return make_error( error::unexpected_end );
+
+		out = *_cursor++;
+		return { error::none };
+	}
+
+	error peek( uint8_t &out ) const
+	{
+		if ( eof() )
+			return make_error( error::unexpected_end );
+
+		out = *_cursor;
+		return { error::none };
+	}
+
+	error get( size_t size, const uint8_t *&out )
+	{
+		if ( remaining() < size )
+			return make_error( error::unexpected_end );
+
+		out = _cursor;
+		_cursor += size;
+		return { error::none };
+	}
+
+	// Read big endian unsigned integer or floating point value
+	template <typename T>
+	error get_be( T &out )
+	{
+		const uint8_t *data = nullptr;
+		if ( auto err = get( sizeof( T ), data ) )
+			return err;
+
+		uint8_t bytes[sizeof( T )];
+		memcpy( bytes, data, sizeof( T ) );
+
+		if constexpr ( std::endian::native == std::endian::little )
+			std::reverse( bytes, bytes + sizeof( T ) );
+
+		memcpy( &out, bytes, sizeof( T ) );
+		return { error::none };
+	}
+
+private:
+	const uint8_t *_begin = nullptr;
+	const uint8_t *_cursor = nullptr;
+	const uint8_t *_end = nullptr;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Checks, if 'd' can be stored as a 64-bit integer without loss
+inline bool is_integral_number( double d ) noexcept
+{
+	if ( d < 0.0 )
+		return d >= -9223372036854775808.0 && double( int64_t( d ) ) == d;
+
+	return d < 18446744073709551616.0 && double( uint64_t( d ) ) == d;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Floating point number read from untrusted input. json5::value keeps its type and pointers in NaN bit patterns,
+// so any NaN payload is replaced with the canonical quiet NaN before a value is made from it.
+inline double decoded_number( double d ) noexcept
+{
+	return ( d != d ) ? std::numeric_limits<double>::quiet_NaN() : d;
+}
+
+} // namespace json5::detail
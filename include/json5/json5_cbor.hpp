@@ -0,0 +1,600 @@
+#pragma once
+
+#include "json5_builder.hpp"
+#include "json5_bytes.hpp"
+
+#include <cmath>
+#include <limits>
+
+/*
+	Direct conversion between json5::document and CBOR (RFC 8949), without going through text.
+
+	Numbers are written as integers when they have no fractional part, otherwise as 64-bit floats. Arrays
+	of numbers can optionally be written as typed arrays (RFC 8746, tag 86: float64 little endian), which copies
+	the document values in bulk. When reading, byte strings become arrays of numbers, typed float arrays
+	are expanded, other tags are ignored and map keys must be text strings.
+*/
+
+namespace json5 {
+
+//---------------------------------------------------------------------------------------------------------------------
+struct cbor_params
+{
+	// Write arrays containing only numbers as little endian float64 typed arrays (tag 86)
+	bool typed_arrays = false;
+};
+
+//
+void to_cbor( std::vector<uint8_t> &out, const json5::value &in, const cbor_params &cp = cbor_params() );
+
+//
+std::vector<uint8_t> to_cbor( const json5::value &in, const cbor_params &cp = cbor_params() );
+
+// Writes to stream in chunks while encoding
+void to_cbor( std::ostream &os, const json5::value &in, const cbor_params &cp = cbor_params() );
+
+//
+error from_cbor( const void *data, size_t size, document &doc );
+
+//
+error from_cbor( const std::vector<uint8_t> &data, document &doc );
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+//---------------------------------------------------------------------------------------------------------------------
+class cbor_writer final
+{
+public:
+	cbor_writer( byte_sink &out, const cbor_params &cp ) : _out( out ), _params( cp ) { }
+
+	void write( const json5::value &v );
+
+private:
+	enum major : uint8_t { unsigned_int = 0, negative_int = 1, byte_string = 2, text_string = 3, array = 4, map = 5, tag = 6 };
+
+	void head( major m, uint64_t arg );
+	void number( double d );
+	void string( std::string_view str );
+	void numbers( const json5::array_view &arr );
+
+	byte_sink &_out;
+	cbor_params _params;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+class cbor_parser final : builder
+{
+public:
+	cbor_parser( document &doc, const void *data, size_t size ) : builder( doc ), _in( data, size ) { }
+
+	// Parse document, root must be a map or an array
+	error parse();
+
+private:
+	error parse_value( value &result );
+	error parse_length( uint8_t info, uint64_t &length );
+	error parse_string( uint8_t info, detail::string_offset &offset );
+	error parse_bytes( uint8_t info, uint64_t tag );
+	error parse_array( uint8_t info );
+	error parse_map( uint8_t info );
+	error parse_simple( uint8_t info, value &result );
+	bool is_break();
+
+	byte_source _in;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void cbor_writer::write( const json5::value &v )
+{
+	if ( v.is_null() )
+		_out.put( 0xf6 );
+	else if ( v.is_boolean() )
+		_out.put( v.get_bool() ? 0xf5 : 0xf4 );
+	else if ( v.is_number() )
+		number( v.get<double>() );
+	else if ( v.is_string() )
+		string( v.get_c_str() );
+	else if ( v.is_array() )
+	{
+		auto arr = json5::array_view( v );
+
+		bool allNumbers = !arr.empty();
+		for ( const auto &i : arr )
+			allNumbers &= i.is_number();
+
+		if ( allNumbers )
+			numbers( arr );
+		else
+		{
+			head( array, arr.size() );
+			for ( const auto &i : arr )
+				write( i );
+		}
+	}
+	else if ( v.is_object() )
+	{
+		auto obj = json5::object_view( v );
+		head( map, obj.size() );
+
+		for ( auto kvp : obj )
+		{
+			string( kvp.first );
+			write( kvp.second );
+		}
+	}
+
+	_out.flush_if_needed();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void cbor_writer::head( major m, uint64_t arg )
+{
+	uint8_t first = uint8_t( m << 5 );
+
+	if ( arg < 24 )
+		_out.put( uint8_t( first | arg ) );
+	else if ( arg <= 0xff )
+	{
+		_out.put( uint8_t( first | 24 ) );
+		_out.put( uint8_t( arg ) );
+	}
+	else if ( arg <= 0xffff )
+	{
+		_out.put( uint8_t( first | 25 ) );
+		_out.put_be( uint16_t( arg ) );
+	}
+	else if ( arg <= 0xffffffff )
+	{
+		_out.put( uint8_t( first | 26 ) );
+		_out.put_be( uint32_t( arg ) );
+	}
+	else
+	{
+		_out.put( uint8_t( first | 27 ) );
+		_out.put_be( uint64_t( arg ) );
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void cbor_writer::number( double d )
+{
+	if ( is_integral_number( d ) )
+	{
+		if ( d < 0.0 )
+			head( negative_int, uint64_t( -1 - int64_t( d ) ) );
+		else
+			head( unsigned_int, uint64_t( d ) );
+	}
+	else
+	{
+		_out.put( 0xfb );
+		_out.put_be( d );
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void cbor_writer::string( std::string_view str )
+{
+	head( text_string, str.size() );
+	_out.put( str.data(), str.size() );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Array of numbers, all items are known to be numbers
+inline void cbor_writer::numbers( const json5::array_view &arr )
+{
+	if ( _params.typed_arrays )
+	{
+		// Document values of numbers are plain doubles, copy them as a whole
+		head( tag, 86 );
+		head( byte_string, arr.size() * sizeof( double ) );
+
+		if constexpr ( std::endian::native == std::endian::little )
+			_out.put( arr.begin(), arr.size() * sizeof( double ) );
+		else
+		{
+			for ( const auto &i : arr )
+			{
+				uint8_t bytes[sizeof( double )];
+				double d = i.get<double>();
+				memcpy( bytes, &d, sizeof( double ) );
+				std::reverse( bytes, bytes + sizeof( double ) );
+				_out.put( bytes, sizeof( double ) );
+			}
+		}
+	}
+	else
+	{
+		head( array, arr.size() );
+
+		_out.reserve( arr.size() * ( 1 + sizeof( double ) ) );
+		for ( const auto &i : arr )
+			number( i.get<double>() );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error cbor_parser::parse()
+{
+	reset();
+
+	if ( auto err = parse_value( _doc ) )
+		return err;
+
+	if ( !_doc.is_array() && !_doc.is_object() )
+		return _in.make_error( error::invalid_root );
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error cbor_parser::parse_value( value &result )
+{
+	uint8_t initial = 0;
+	if ( auto err = _in.get( initial ) )
+		return err;
+
+	uint8_t info = initial & 31;
+	uint64_t arg = 0;
+
+	// Only strings, arrays and maps can have indefinite length
+	if ( info == 31 && ( initial >> 5 ) != 2 && ( initial >> 5 ) != 3 && ( initial >> 5 ) != 4 && ( initial >> 5 ) != 5 )
+		return _in.make_error( error::syntax_error );
+
+	switch ( initial >> 5 )
+	{
+		case 0:
+			if ( auto err = parse_length( info, arg ) )
+				return err;
+
+			result = value( double( arg ) );
+			break;
+
+		case 1:
+			if ( auto err = parse_length( info, arg ) )
+				return err;
+
+			result = value( -1.0 - double( arg ) );
+			break;
+
+		case 2:
+			push_array();
+			{
+				if ( auto err = parse_bytes( info, 0 ) )
+					return err;
+			}
+			result = pop();
+			break;
+
+		case 3:
+		{
+			detail::string_offset offset = 0;
+			if ( auto err = parse_string( info, offset ) )
+				return err;
+
+			result = new_string( offset );
+		}
+		break;
+
+		case 4:
+			push_array();
+			{
+				if ( auto err = parse_array( info ) )
+					return err;
+			}
+			result = pop();
+			break;
+
+		case 5:
+			push_object();
+			{
+				if ( auto err = parse_map( info ) )
+					return err;
+			}
+			result = pop();
+			break;
+
+		case 6:
+		{
+			if ( auto err = parse_length( info, arg ) )
+				return err;
+
+			// Typed float arrays are expanded to arrays of numbers, other tags are ignored
+			uint8_t next = 0;
+			if ( ( arg == 85 || arg == 86 ) && !_in.peek( next ) && ( next >> 5 ) == 2 )
+			{
+				_in.get( next );
+
+				push_array();
+				{
+					if ( auto err = parse_bytes( next & 31, arg ) )
+						return err;
+				}
+				result = pop();
+			}
+			else if ( auto err = parse_value( result ) )
+				return err;
+		}
+		break;
+
+		default:
+			return parse_simple( info, result );
+	}
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Argument of the initial byte, 'length' is set to uint64_t( -1 ) for indefinite length items
+inline error cbor_parser::parse_length( uint8_t info, uint64_t &length )
+{
+	if ( info < 24 )
+	{
+		length = info;
+		return { error::none };
+	}
+
+	switch ( info )
+	{
+		case 24: { uint8_t v = 0; auto err = _in.get_be( v ); length = v; return err; }
+		case 25: { uint16_t v = 0; auto err = _in.get_be( v ); length = v; return err; }
+		case 26: { uint32_t v = 0; auto err = _in.get_be( v ); length = v; return err; }
+		case 27: return _in.get_be( length );
+		case 31: length = uint64_t( -1 ); return { error::none };
+	}
+
+	return _in.make_error( error::syntax_error );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool cbor_parser::is_break()
+{
+	uint8_t next = 0;
+	if ( _in.peek( next ) || next != 0xff )
+		return false;
+
+	_in.get( next );
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Text string, indefinite length strings are concatenated from their chunks
+inline error cbor_parser::parse_string( uint8_t info, detail::string_offset &offset )
+{
+	uint64_t length = 0;
+	if ( auto err = parse_length( info, length ) )
+		return err;
+
+	offset = string_buffer_offset();
+	auto &strings = string_buffer();
+
+	if ( length != uint64_t( -1 ) )
+	{
+		const uint8_t *data = nullptr;
+		if ( auto err = _in.get( size_t( length ), data ) )
+			return err;
+
+		strings.append( reinterpret_cast<const char *>( data ), size_t( length ) );
+	}
+	else
+	{
+		while ( !is_break() )
+		{
+			uint8_t chunk = 0;
+			if ( auto err = _in.get( chunk ) )
+				return err;
+
+			if ( ( chunk >> 5 ) != 3 || ( chunk & 31 ) == 31 )
+				return _in.make_error( error::string_expected );
+
+			const uint8_t *data = nullptr;
+			if ( auto err = parse_length( chunk & 31, length ) )
+				return err;
+
+			if ( auto err = _in.get( size_t( length ), data ) )
+				return err;
+
+			strings.append( reinterpret_cast<const char *>( data ), size_t( length ) );
+		}
+	}
+
+	strings.push_back( 0 );
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Byte string as array items: plain bytes, or float32 (tag 85) / float64 (tag 86) little endian typed array
+inline error cbor_parser::parse_bytes( uint8_t info, uint64_t tag )
+{
+	uint64_t length = 0;
+	if ( auto err = parse_length( info, length ) )
+		return err;
+
+	if ( length == uint64_t( -1 ) )
+		return _in.make_error( error::syntax_error );
+
+	size_t itemSize = ( tag == 86 ) ? 8 : ( tag == 85 ) ? 4 : 1;
+	if ( length % itemSize )
+		return _in.make_error( error::syntax_error );
+
+	const uint8_t *data = nullptr;
+	if ( auto err = _in.get( size_t( length ), data ) )
+		return err;
+
+	for ( size_t i = 0, numItems = size_t( length ) / itemSize; i < numItems; ++i, data += itemSize )
+	{
+		if ( itemSize == 1 )
+			( *this ) += value( double( *data ) );
+		else
+		{
+			uint8_t bytes[8];
+			memcpy( bytes, data, itemSize );
+
+			if constexpr ( std::endian::native != std::endian::little )
+				std::reverse( bytes, bytes + itemSize );
+
+			if ( itemSize == 8 )
+			{
+				double d;
+				memcpy( &d, bytes, 8 );
+				( *this ) += value( detail::decoded_number( d ) );
+			}
+			else
+			{
+				float f;
+				memcpy( &f, bytes, 4 );
+				( *this ) += value( detail::decoded_number( f ) );
+			}
+		}
+	}
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error cbor_parser::parse_array( uint8_t info )
+{
+	uint64_t length = 0;
+	if ( auto err = parse_length( info, length ) )
+		return err;
+
+	for ( uint64_t i = 0; length == uint64_t( -1 ) ? !is_break() : i < length; ++i )
+	{
+		value newValue;
+		if ( auto err = parse_value( newValue ) )
+			return err;
+
+		( *this ) += newValue;
+	}
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error cbor_parser::parse_map( uint8_t info )
+{
+	uint64_t length = 0;
+	if ( auto err = parse_length( info, length ) )
+		return err;
+
+	for ( uint64_t i = 0; length == uint64_t( -1 ) ? !is_break() : i < length; ++i )
+	{
+		uint8_t keyInitial = 0;
+		if ( auto err = _in.get( keyInitial ) )
+			return err;
+
+		if ( ( keyInitial >> 5 ) != 3 )
+			return _in.make_error( error::string_expected );
+
+		detail::string_offset keyOffset = 0;
+		if ( auto err = parse_string( keyInitial & 31, keyOffset ) )
+			return err;
+
+		value newValue;
+		if ( auto err = parse_value( newValue ) )
+			return err;
+
+		( *this )[keyOffset] = newValue;
+	}
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error cbor_parser::parse_simple( uint8_t info, value &result )
+{
+	switch ( info )
+	{
+		case 20: result = value( false ); break;
+		case 21: result = value( true ); break;
+		case 22:
+		case 23: result = value(); break;
+
+		case 25:
+		{
+			uint16_t half = 0;
+			if ( auto err = _in.get_be( half ) )
+				return err;
+
+			int exponent = ( half >> 10 ) & 0x1f;
+			double mantissa = half & 0x3ff;
+			double d = ( exponent == 0 ) ? std::ldexp( mantissa, -24 )
+			         : ( exponent == 31 ) ? ( mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN() )
+			         : std::ldexp( mantissa + 1024, exponent - 25 );
+
+			result = value( ( half & 0x8000 ) ? -d : d );
+		}
+		break;
+
+		case 26:
+		{
+			float f = 0.0f;
+			if ( auto err = _in.get_be( f ) )
+				return err;
+
+			result = value( detail::decoded_number( f ) );
+		}
+		break;
+
+		case 27:
+		{
+			double d = 0.0;
+			if ( auto err = _in.get_be( d ) )
+				return err;
+
+			result = value( detail::decoded_number( d ) );
+		}
+		break;
+
+		default:
+			return _in.make_error( error::syntax_error );
+	}
+
+	return { error::none };
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void to_cbor( std::vector<uint8_t> &out, const json5::value &in, const cbor_params &cp )
+{
+	out.clear();
+	detail::byte_sink sink( out );
+	detail::cbor_writer( sink, cp ).write( in );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<uint8_t> to_cbor( const json5::value &in, const cbor_params &cp )
+{
+	std::vector<uint8_t> result;
+	to_cbor( result, in, cp );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void to_cbor( std::ostream &os, const json5::value &in, const cbor_params &cp )
+{
+	detail::byte_sink sink( os );
+	detail::cbor_writer( sink, cp ).write( in );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error from_cbor( const void *data, size_t size, document &doc )
+{
+	detail::cbor_parser p( doc, data, size );
+	return p.parse();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error from_cbor( const std::vector<uint8_t> &data, document &doc )
+{
+	return from_cbor( data.data(), data.size(), doc );
+}
+
+} // namespace json5
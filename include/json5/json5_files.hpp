@@ -0,0 +1,174 @@
+#pragma once
+
+#include "json5_input.hpp"
+#include "json5_parallel.hpp"
+
+#include <filesystem>
+#include <span>
+
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#define _JSON5_HAS_MMAP
+#endif
+
+namespace json5 {
+
+// Document loaded by 'load_files', or the error which prevented loading it
+struct loaded_file
+{
+	document doc;
+	error err;
+};
+
+// Parse json5::document from file, reusing scratch buffers of 'context'. Large files are memory mapped where supported.
+error from_file( const std::filesystem::path &fileName, document &doc, parse_context &context );
+
+// Loads and parses 'paths' concurrently, results are in order of 'paths'. Up to 'num_threads' threads pick
+// 'chunk_size' files at a time, so a few large files do not hold up the rest. Each thread reuses one parse_context.
+std::vector<loaded_file> load_files( std::span<const std::filesystem::path> paths, const parallel_params &pp = parallel_params{ 0, 1 } );
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+/*
+
+json5::detail::mapped_file
+
+Read-only view of a file's contents. Large files are memory mapped on POSIX systems. Small files (where
+mapping costs more than copying) are read into a caller provided buffer, as are all files elsewhere.
+
+*/
+class mapped_file final
+{
+public:
+	mapped_file( const std::filesystem::path &fileName, std::string &fallback );
+	~mapped_file();
+
+	mapped_file( const mapped_file & ) = delete;
+	mapped_file &operator=( const mapped_file & ) = delete;
+
+	bool is_open() const noexcept { return _open; }
+	std::string_view data() const noexcept { return _data; }
+
+private:
+	bool read( const std::filesystem::path &fileName, std::string &fallback );
+
+	static constexpr size_t map_threshold = 64 * 1024;
+
+	std::string_view _data;
+	void *_mapping = nullptr;
+	bool _open = false;
+};
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline detail::mapped_file::mapped_file( const std::filesystem::path &fileName, std::string &fallback )
+{
+#if defined(_JSON5_HAS_MMAP)
+	int fd = ::open( fileName.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return;
+
+	struct stat st = { };
+	if ( ::fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) )
+	{
+		const auto size = size_t( st.st_size );
+
+		if ( size >= map_threshold )
+		{
+			void *mapping = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+			if ( mapping != MAP_FAILED )
+			{
+				::madvise( mapping, size, MADV_SEQUENTIAL );
+				_mapping = mapping;
+				_data = std::string_view( static_cast<const char *>( mapping ), size );
+				_open = true;
+			}
+		}
+		else
+		{
+			fallback.resize( size );
+
+			size_t done = 0;
+			for ( ssize_t n = 0; done < size && ( n = ::read( fd, fallback.data() + done, size - done ) ) > 0; )
+				done += size_t( n );
+
+			if ( done == size )
+			{
+				_data = fallback;
+				_open = true;
+			}
+		}
+	}
+
+	::close( fd );
+
+	if ( _open )
+		return;
+#endif
+
+	_open = read( fileName, fallback );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline detail::mapped_file::~mapped_file()
+{
+#if defined(_JSON5_HAS_MMAP)
+	if ( _mapping )
+		::munmap( _mapping, _data.size() );
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool detail::mapped_file::read( const std::filesystem::path &fileName, std::string &fallback )
+{
+	std::ifstream ifs( fileName, std::ios::binary );
+	if ( !ifs.is_open() )
+		return false;
+
+	fallback.clear();
+
+	char buff[4096];
+	while ( ifs.read( buff, sizeof( buff ) ) || ifs.gcount() > 0 )
+		fallback.append( buff, size_t( ifs.gcount() ) );
+
+	_data = fallback;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error from_file( const std::filesystem::path &fileName, document &doc, parse_context &context )
+{
+	detail::mapped_file file( fileName, context.file_buffer() );
+	if ( !file.is_open() )
+		return error{ error::could_not_open, 0, 0 };
+
+	return from_string( file.data(), doc, context );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<loaded_file> load_files( std::span<const std::filesystem::path> paths, const parallel_params &pp )
+{
+	std::vector<loaded_file> result( paths.size() );
+	std::vector<parse_context> contexts( detail::num_threads( pp ) );
+
+	// Each file has its own result slot, each thread its own context
+	detail::parallel_for( paths.size(), pp, [&]( unsigned thread, size_t begin, size_t end )
+	{
+		for ( size_t i = begin; i < end; ++i )
+			result[i].err = from_file( paths[i], result[i].doc, contexts[thread] );
+	} );
+
+	return result;
+}
+
+} // namespace json5
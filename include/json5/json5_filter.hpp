@@ -2,108 +2,1046 @@
 
 #include "json5.hpp"
 
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace json5 {
 
+namespace detail {
+
+/*
+	Matching automaton of one or more patterns. Every segment is a state, each pattern is terminated
+	by an 'accept' state. A set of states is tracked per visited value.
+*/
+class filter_program final
+{
+public:
+	struct state
+	{
+		enum type_t : uint8_t { key, any, descend, index, slice, predicate, never, accept };
+		enum compare_t : uint8_t { exists, equal, not_equal };
+
+		type_t type = accept;
+		compare_t compare = exists;
+		value_type operand = value_type::null;
+		uint32_t pattern = 0;
+
+		// Key name of 'key' and 'predicate' states is stored in 'filter_program', see 'key_equals'
+		uint32_t key_offset = 0;
+		uint32_t key_length = 0;
+		uint32_t key_hash = 0;
+
+		// Array index of 'index' state, [first, last) range of 'slice' state. Negative values count from the end.
+		int64_t first = 0;
+		int64_t last = 0;
+
+		// Operand of 'predicate' state compared with its key, string operands are stored in 'filter_program'
+		uint32_t string_offset = 0;
+		uint32_t string_length = 0;
+		double number = 0.0;
+	};
+
+	using word = uint64_t;
+	static constexpr size_t word_bits = 64;
+
+	// Appends pattern, returns number of its segments
+	size_t add_pattern( std::string_view pattern );
+
+	size_t num_states() const noexcept { return _states.size(); }
+	size_t num_patterns() const noexcept { return _starts.size(); }
+	size_t num_words() const noexcept { return ( _states.size() + word_bits - 1 ) / word_bits; }
+
+	const state &operator[]( size_t index ) const noexcept { return _states[index]; }
+
+	// Set of start states of all patterns (before closure)
+	void start( word *set ) const noexcept;
+
+	// Adds states reachable without consuming a level ('**' matching no level)
+	void close( word *set ) const noexcept;
+
+	// Checks, if 'set' contains any state which can match items of a container
+	bool consumes( const word *set ) const noexcept;
+
+	// Checks, if null terminated 'name' equals key name of state 's'
+	bool key_equals( const state &s, const char *name ) const noexcept
+	{
+		return strncmp( name, _keys.data() + s.key_offset, s.key_length ) == 0 && name[s.key_length] == 0;
+	}
+
+	// Checks, if item at 'index' of an array with 'count' items is selected by 'index' or 'slice' state 's'
+	static bool index_matches( const state &s, size_t index, size_t count ) noexcept;
+
+	// Checks, if 'v' satisfies 'predicate' state 's'
+	bool predicate_matches( const state &s, const json5::value &v ) const noexcept;
+
+	// Computes closed state set 'out' of 'child' from state set 'in' of its container. 'key' is null for array
+	// items, 'index' is -1 for object items. Returns false if 'out' is empty.
+	bool transition( const word *in, word *out, const char *key, size_t index, size_t count, const json5::value &child ) const noexcept;
+
+	// Key hashes are compared first, when there are many key states
+	bool hash_keys() const noexcept { return _numKeys > 8; }
+
+private:
+	static size_t find_segment_end( std::string_view pattern ) noexcept;
+	size_t add_segment( std::string_view head, uint32_t patternIndex );
+	bool parse_selector( std::string_view text, state &s );
+	bool parse_predicate( std::string_view text, state &s );
+	void set_key( state &s, std::string_view name );
+	void push_state( const state &s );
+
+	std::vector<state> _states;
+	std::vector<uint32_t> _starts;
+	std::vector<uint32_t> _descends;
+	std::vector<word> _acceptMask;
+	std::string _keys;
+	size_t _numKeys = 0;
+};
+
+} // namespace detail
+
+/*
+	Filter pattern parsed once into segments. Segments are separated by '/' and can be:
+
+	- key name, optionally in single or double quotes (which may contain '/')
+	- '*', any item of an object or an array (or a value itself, when used as the last segment on a non-container)
+	- '**', any number of nested levels, including none
+
+	Each of them can be followed by selectors applied to the next level, e.g. 'statuses[0:10]/user':
+
+	- '[3]', '[-1]', array item by index, negative index counts from the end
+	- '[2:5]', '[:-1]', '[1:]', array items in a half-open range
+	- '[*]', any item, '['key']', item by quoted key name
+	- '[?(@.key)]', '[?(@.key == 'ok')]', '[?(@.count != 0)]', items of an object or an array, which are objects
+	  with 'key' present or equal (or not equal) to a string, number, true, false or null
+
+	Matching walks the document once, each value is visited at most once and reported at most once, in document
+	order. Compiled filter is immutable, one instance can be used with many documents and from multiple threads.
+*/
+class compiled_filter final
+{
+public:
+	compiled_filter() : compiled_filter( std::string_view() ) { }
+	explicit compiled_filter( std::string_view pattern ) { _size = _program.add_pattern( pattern ); }
+
+	// Number of pattern segments
+	size_t size() const noexcept { return _size; }
+	bool empty() const noexcept { return _size == 0; }
+
+	const detail::filter_program &program() const noexcept { return _program; }
+
+private:
+	detail::filter_program _program;
+	size_t _size = 0;
+};
+
+/*
+	Many filter patterns compiled into one automaton, so they are all matched in a single traversal.
+	Matches are reported with the index of the pattern, in document order. When one value matches
+	several patterns, it is reported once for each of them, in pattern order.
+*/
+class filter_set final
+{
+public:
+	filter_set() = default;
+	explicit filter_set( std::initializer_list<std::string_view> patterns ) { for ( auto p : patterns ) add( p ); }
+
+	// Adds pattern, returns its index
+	size_t add( std::string_view pattern ) { _program.add_pattern( pattern ); return _program.num_patterns() - 1; }
+
+	// Number of patterns
+	size_t size() const noexcept { return _program.num_patterns(); }
+	bool empty() const noexcept { return _program.num_patterns() == 0; }
+
+	const detail::filter_program &program() const noexcept { return _program; }
+
+private:
+	detail::filter_program _program;
+};
+
+//
+template <typename Func> void filter( const json5::value &in, const compiled_filter &pattern, Func &&func );
+
 //
 template <typename Func> void filter( const json5::value &in, std::string_view pattern, Func &&func );
 
+//
+std::vector<json5::value> filter( const json5::value &in, const compiled_filter &pattern );
+
 //
 std::vector<json5::value> filter( const json5::value &in, std::string_view pattern );
 
+// Calls 'func( patternIndex, value )' for every match of every pattern in 'patterns'
+template <typename Func> void filter( const json5::value &in, const filter_set &patterns, Func &&func );
+
+// Returns matches of each pattern in 'patterns', indexed by pattern
+std::vector<std::vector<json5::value>> filter( const json5::value &in, const filter_set &patterns );
+
+// Finds the first match in document order, stops the traversal there. Returns false if there is none.
+bool filter_first( const json5::value &in, const compiled_filter &pattern, json5::value &out );
+
+//
+bool filter_first( const json5::value &in, std::string_view pattern, json5::value &out );
+
+// Counts matches, stops the traversal once 'limit' is reached
+size_t filter_count( const json5::value &in, const compiled_filter &pattern, size_t limit = size_t( -1 ) );
+
+//
+size_t filter_count( const json5::value &in, std::string_view pattern, size_t limit = size_t( -1 ) );
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace detail {
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool test_bit( const filter_program::word *set, size_t index ) noexcept
+{
+	return ( set[index / filter_program::word_bits] >> ( index % filter_program::word_bits ) ) & 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void set_bit( filter_program::word *set, size_t index ) noexcept
+{
+	set[index / filter_program::word_bits] |= filter_program::word( 1 ) << ( index % filter_program::word_bits );
+}
+
 //---------------------------------------------------------------------------------------------------------------------
+// Calls 'func( index )' for every bit set in 'set'
 template <typename Func>
-inline void filter( const json5::value &in, std::string_view pattern, Func &&func )
+inline void for_each_bit( const filter_program::word *set, size_t numWords, const Func &func )
+{
+	for ( size_t w = 0; w < numWords; ++w )
+		for ( auto bits = set[w]; bits; bits &= bits - 1 )
+			func( w * filter_program::word_bits + size_t( std::countr_zero( bits ) ) );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns index of the first bit set in 'set' at or after 'from', or -1 if there is none
+inline size_t next_bit( const filter_program::word *set, size_t numWords, size_t from ) noexcept
 {
-	if ( pattern.empty() )
+	for ( size_t w = from / filter_program::word_bits; w < numWords; ++w )
 	{
-		func( in );
-		return;
+		auto bits = set[w];
+		if ( w == from / filter_program::word_bits )
+			bits &= ~filter_program::word( 0 ) << ( from % filter_program::word_bits );
+
+		if ( bits )
+			return w * filter_program::word_bits + size_t( std::countr_zero( bits ) );
 	}
 
-	std::string_view head = pattern;
-	std::string_view tail = pattern;
+	return size_t( -1 );
+}
+
+/*
+	Walks a document with a 'filter_program' and reports matches one at a time in document order.
+	Uses an explicit stack, so it can be suspended between matches.
+*/
+class filter_walker final
+{
+public:
+	// Arrays with more than 'splitSize' items are not descended into, see 'split'
+	filter_walker( const filter_program &program, const json5::value &root, size_t splitSize = size_t( -1 ) );
 
-	if ( auto slash = pattern.find( "/" ); slash != std::string_view::npos )
+	// Starts at 'node' with closed state set 'set' (from 'filter_program::transition')
+	filter_walker( const filter_program &program, const json5::value &node, const filter_program::word *set );
+
+	// Starts over at 'node' with closed state set 'set', reuses memory
+	void restart( const json5::value &node, const filter_program::word *set );
+
+	// Finds next match, returns false when there are no more, or when traversal stopped at a large array
+	bool next( json5::value &out, size_t &pattern );
+
+	// Large array traversal stopped at, its items can be matched separately with the 'split_set' state set.
+	// Call 'resume' to continue after the array.
+	bool split() const noexcept { return _split.is_array(); }
+	const json5::value &split_array() const noexcept { return _split; }
+	const filter_program::word *split_set() noexcept { return set( _stack.size() ); }
+	void resume() noexcept { _split = json5::value(); }
+
+private:
+	using word = filter_program::word;
+
+	struct frame
 	{
-		head = pattern.substr( 0, slash );
-		tail = pattern.substr( slash + 1 );
-	}
-	else
-		tail = std::string_view();
+		bool object = false;
+		object_view::iterator object_item, object_end;
+		array_view::iterator array_item = nullptr, array_end = nullptr;
+		size_t array_index = 0, array_size = 0;
+	};
+
+	word *set( size_t slot ) noexcept { return _sets.data() + slot * _numWords; }
+
+	void enter( const json5::value &node, size_t slot );
+	bool step( size_t parentSlot, const frame &parent, const char *key, const json5::value &child, size_t childSlot );
+	bool accepts( size_t index, const json5::value &node ) const noexcept;
 
-	// Trim whitespace
+	const filter_program &_program;
+	size_t _numWords = 0;
+	size_t _splitSize = size_t( -1 );
+	std::vector<word> _sets;
+	std::vector<frame> _stack;
+	json5::value _split;
+
+	// Accept states of the last entered value are reported from '_pendingState' on
+	json5::value _pending;
+	size_t _pendingSlot = 0;
+	size_t _pendingState = size_t( -1 );
+	size_t _pendingPattern = size_t( -1 );
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::string_view trim( std::string_view str ) noexcept
+{
+	while ( !str.empty() && isspace( uint8_t( str.front() ) ) ) str.remove_prefix( 1 );
+	while ( !str.empty() && isspace( uint8_t( str.back() ) ) ) str.remove_suffix( 1 );
+	return str;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool parse_integer( std::string_view str, int64_t &out ) noexcept
+{
+	str = trim( str );
+	auto result = std::from_chars( str.data(), str.data() + str.size(), out );
+	return result.ec == std::errc() && result.ptr == str.data() + str.size();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Returns position of '/' ending the first segment of 'pattern', or npos. Skips '/' in quotes and brackets.
+inline size_t filter_program::find_segment_end( std::string_view pattern ) noexcept
+{
+	size_t i = 0;
+	while ( i < pattern.size() && isspace( uint8_t( pattern[i] ) ) ) ++i;
+
+	// Quoted key may contain '/'
+	if ( i < pattern.size() && ( pattern[i] == '\'' || pattern[i] == '"' ) )
 	{
-		while ( !head.empty() && isspace( head.front() ) ) head.remove_prefix( 1 );
-		while ( !head.empty() && isspace( head.back() ) ) head.remove_suffix( 1 );
+		if ( size_t close = pattern.find( pattern[i], i + 1 ); close != std::string_view::npos )
+			i = close + 1;
 	}
 
-	if ( head == "*" )
+	for ( int depth = 0; i < pattern.size(); ++i )
 	{
-		if ( in.is_object() )
+		char ch = pattern[i];
+
+		if ( ch == '/' && depth == 0 )
+			return i;
+		else if ( ch == '[' )
+			++depth;
+		else if ( ch == ']' && depth > 0 )
+			--depth;
+		else if ( depth > 0 && ( ch == '\'' || ch == '"' ) )
 		{
-			for ( auto kvp : object_view( in ) )
-				filter( kvp.second, tail, std::forward<Func>( func ) );
+			size_t close = pattern.find( ch, i + 1 );
+			if ( close == std::string_view::npos )
+				return std::string_view::npos;
+
+			i = close;
 		}
-		else if ( in.is_array() )
+	}
+
+	return std::string_view::npos;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline size_t filter_program::add_pattern( std::string_view pattern )
+{
+	auto patternIndex = uint32_t( _starts.size() );
+	_starts.push_back( uint32_t( _states.size() ) );
+
+	size_t numSegments = 0;
+
+	while ( !pattern.empty() )
+	{
+		size_t end = find_segment_end( pattern );
+		numSegments += add_segment( pattern.substr( 0, end ), patternIndex );
+		pattern.remove_prefix( end != std::string_view::npos ? end + 1 : pattern.size() );
+	}
+
+	state accept;
+	accept.pattern = patternIndex;
+	push_state( accept );
+
+	return numSegments;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Adds states of one segment: optional key name, '*' or '**', followed by any number of '[...]' selectors
+inline size_t filter_program::add_segment( std::string_view head, uint32_t patternIndex )
+{
+	head = trim( head );
+
+	std::string_view name = head;
+	std::string_view selectors;
+	bool quoted = false;
+
+	if ( head.size() >= 2 && ( head.front() == '\'' || head.front() == '"' ) )
+	{
+		if ( size_t close = head.find( head.front(), 1 ); close != std::string_view::npos )
 		{
-			for ( auto v : array_view( in ) )
-				filter( v, tail, std::forward<Func>( func ) );
+			name = head.substr( 1, close - 1 );
+			selectors = trim( head.substr( close + 1 ) );
+			quoted = true;
 		}
-		else
-			filter( in, std::string_view(), std::forward<Func>( func ) );
 	}
-	else if ( head == "**" )
+	else if ( size_t open = head.find( '[' ); open != std::string_view::npos )
 	{
-		if ( in.is_object() )
-		{
-			filter( in, tail, std::forward<Func>( func ) );
+		name = trim( head.substr( 0, open ) );
+		selectors = head.substr( open );
+	}
+
+	size_t numStates = 0;
+	state s;
+	s.pattern = patternIndex;
 
-			for ( auto kvp : object_view( in ) )
+	if ( !quoted && name == "*" )
+		s.type = state::any;
+	else if ( !quoted && name == "**" )
+		s.type = state::descend;
+	else if ( quoted || !name.empty() || selectors.empty() )
+		set_key( s, name );
+
+	if ( s.type != state::accept )
+	{
+		push_state( s );
+		++numStates;
+	}
+
+	while ( !selectors.empty() )
+	{
+		state sel;
+		sel.pattern = patternIndex;
+
+		size_t close = std::string_view::npos;
+		if ( selectors.front() == '[' )
+		{
+			// Find matching ']', skipping quoted strings
+			for ( size_t i = 1; i < selectors.size(); ++i )
 			{
-				filter( kvp.second, tail, std::forward<Func>( func ) );
-				filter( kvp.second, pattern, std::forward<Func>( func ) );
+				if ( selectors[i] == '\'' || selectors[i] == '"' )
+				{
+					if ( i = selectors.find( selectors[i], i + 1 ); i == std::string_view::npos )
+						break;
+				}
+				else if ( selectors[i] == ']' )
+				{
+					close = i;
+					break;
+				}
 			}
 		}
-		else if ( in.is_array() )
+
+		if ( close == std::string_view::npos || !parse_selector( trim( selectors.substr( 1, close - 1 ) ), sel ) )
 		{
-			for ( auto v : array_view( in ) )
-			{
-				filter( v, tail, std::forward<Func>( func ) );
-				filter( v, pattern, std::forward<Func>( func ) );
-			}
+			sel.type = state::never;
+			selectors = std::string_view();
 		}
+		else
+			selectors = trim( selectors.substr( close + 1 ) );
+
+		push_state( sel );
+		++numStates;
+	}
+
+	return numStates;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Parses content of '[...]': '*', index, slice, quoted key name or '?(...)' predicate
+inline bool filter_program::parse_selector( std::string_view text, state &s )
+{
+	if ( text == "*" )
+	{
+		s.type = state::any;
+		return true;
+	}
+
+	if ( !text.empty() && text.front() == '?' )
+		return parse_predicate( trim( text.substr( 1 ) ), s );
+
+	if ( text.size() >= 2 && ( text.front() == '\'' || text.front() == '"' ) && text.back() == text.front() )
+	{
+		set_key( s, text.substr( 1, text.size() - 2 ) );
+		return true;
 	}
+
+	if ( size_t colon = text.find( ':' ); colon != std::string_view::npos )
+	{
+		auto first = trim( text.substr( 0, colon ) );
+		auto last = trim( text.substr( colon + 1 ) );
+
+		s.type = state::slice;
+		s.first = 0;
+		s.last = std::numeric_limits<int64_t>::max();
+		return ( first.empty() || parse_integer( first, s.first ) ) && ( last.empty() || parse_integer( last, s.last ) );
+	}
+
+	s.type = state::index;
+	return parse_integer( text, s.first );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Parses '(@.key)' or '(@.key == operand)' with '==' or '!=', operand is a quoted string, number, true, false or null
+inline bool filter_program::parse_predicate( std::string_view text, state &s )
+{
+	if ( text.size() < 2 || text.front() != '(' || text.back() != ')' )
+		return false;
+
+	text = trim( text.substr( 1, text.size() - 2 ) );
+	if ( text.size() < 2 || text[0] != '@' || text[1] != '.' )
+		return false;
+
+	text = trim( text.substr( 2 ) );
+
+	// Key name, optionally quoted
+	std::string_view name;
+	if ( !text.empty() && ( text.front() == '\'' || text.front() == '"' ) )
+	{
+		size_t close = text.find( text.front(), 1 );
+		if ( close == std::string_view::npos )
+			return false;
+
+		name = text.substr( 1, close - 1 );
+		text = trim( text.substr( close + 1 ) );
+	}
+	else
+	{
+		size_t end = 0;
+		while ( end < text.size() && !isspace( uint8_t( text[end] ) ) && text[end] != '=' && text[end] != '!' ) ++end;
+
+		name = text.substr( 0, end );
+		text = trim( text.substr( end ) );
+	}
+
+	set_key( s, name );
+	s.type = state::predicate;
+	s.compare = state::exists;
+
+	if ( text.empty() )
+		return !name.empty();
+
+	if ( text.starts_with( "==" ) )
+		s.compare = state::equal;
+	else if ( text.starts_with( "!=" ) )
+		s.compare = state::not_equal;
+	else
+		return false;
+
+	text = trim( text.substr( 2 ) );
+
+	if ( text.size() >= 2 && ( text.front() == '\'' || text.front() == '"' ) && text.back() == text.front() )
+	{
+		s.operand = value_type::string;
+		s.string_offset = uint32_t( _keys.size() );
+		s.string_length = uint32_t( text.size() - 2 );
+		_keys += text.substr( 1, text.size() - 2 );
+	}
+	else if ( text == "true" || text == "false" )
+	{
+		s.operand = value_type::boolean;
+		s.number = text == "true" ? 1.0 : 0.0;
+	}
+	else if ( text == "null" )
+		s.operand = value_type::null;
 	else
 	{
-		if ( in.is_object() )
+		std::string number( text );
+		char *end = nullptr;
+		s.operand = value_type::number;
+		s.number = strtod( number.c_str(), &end );
+
+		if ( number.empty() || end != number.c_str() + number.size() )
+			return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void filter_program::set_key( state &s, std::string_view name )
+{
+	s.type = state::key;
+	s.key_offset = uint32_t( _keys.size() );
+	s.key_length = uint32_t( name.size() );
+	s.key_hash = hash_name( name );
+	_keys += name;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void filter_program::push_state( const state &s )
+{
+	if ( s.type == state::descend )
+		_descends.push_back( uint32_t( _states.size() ) );
+	else if ( s.type == state::key )
+		++_numKeys;
+
+	_states.push_back( s );
+	_acceptMask.resize( num_words() );
+
+	if ( s.type == state::accept )
+		set_bit( _acceptMask.data(), _states.size() - 1 );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_program::index_matches( const state &s, size_t index, size_t count ) noexcept
+{
+	auto resolve = [count]( int64_t i ) { return i < 0 ? int64_t( count ) + i : i; };
+
+	if ( s.type == state::index )
+		return int64_t( index ) == resolve( s.first );
+
+	return int64_t( index ) >= resolve( s.first ) && int64_t( index ) < resolve( s.last );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_program::predicate_matches( const state &s, const json5::value &v ) const noexcept
+{
+	if ( !v.is_object() )
+		return false;
+
+	for ( auto kvp : object_view( v ) )
+	{
+		if ( !key_equals( s, kvp.first ) )
+			continue;
+
+		const auto &field = kvp.second;
+		bool equal = false;
+
+		switch ( s.operand )
+		{
+			case value_type::string:
+				equal = field.is_string() &&
+				        std::string_view( field.get_c_str() ) == std::string_view( _keys.data() + s.string_offset, s.string_length );
+				break;
+
+			case value_type::number: equal = field.is_number() && field.get<double>() == s.number; break;
+			case value_type::boolean: equal = field.is_boolean() && field.get_bool() == ( s.number != 0.0 ); break;
+			default: equal = field.is_null(); break;
+		}
+
+		return s.compare == state::exists || ( s.compare == state::equal ? equal : !equal );
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_program::transition( const word *in, word *out, const char *key, size_t index, size_t count,
+                                        const json5::value &child ) const noexcept
+{
+	const size_t numWords = num_words();
+	std::fill( out, out + numWords, word( 0 ) );
+
+	uint32_t keyHash = 0;
+	bool hashed = !key || !hash_keys();
+	bool any = false;
+
+	for_each_bit( in, numWords, [&]( size_t i )
+	{
+		const auto &s = _states[i];
+
+		switch ( s.type )
 		{
-			// Remove string quotes
-			if ( head.size() >= 2 )
+			case state::key:
+				if ( !key )
+					return;
+
+				if ( !hashed )
+				{
+					keyHash = hash_name( key );
+					hashed = true;
+				}
+
+				if ( ( keyHash == s.key_hash || !hash_keys() ) && key_equals( s, key ) )
+					set_bit( out, i + 1 ), any = true;
+
+				break;
+
+			case state::any:
+				set_bit( out, i + 1 ), any = true;
+				break;
+
+			case state::descend:
+				set_bit( out, i ), any = true;
+				break;
+
+			case state::index:
+			case state::slice:
+				if ( index != size_t( -1 ) && index_matches( s, index, count ) )
+					set_bit( out, i + 1 ), any = true;
+
+				break;
+
+			case state::predicate:
+				if ( predicate_matches( s, child ) )
+					set_bit( out, i + 1 ), any = true;
+
+				break;
+
+			case state::never:
+			case state::accept:
+				break;
+		}
+	} );
+
+	if ( any )
+		close( out );
+
+	return any;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void filter_program::start( word *set ) const noexcept
+{
+	for ( auto s : _starts )
+		set_bit( set, s );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void filter_program::close( word *set ) const noexcept
+{
+	// Ascending order, so chains like '**' / '**' are closed in one pass
+	for ( auto d : _descends )
+		if ( test_bit( set, d ) )
+			set_bit( set, d + 1 );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_program::consumes( const word *set ) const noexcept
+{
+	for ( size_t w = 0, numWords = num_words(); w < numWords; ++w )
+		if ( set[w] & ~_acceptMask[w] )
+			return true;
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline filter_walker::filter_walker( const filter_program &program, const json5::value &root, size_t splitSize )
+	: _program( program )
+	, _numWords( program.num_words() )
+	, _splitSize( splitSize )
+{
+	if ( !_numWords )
+		return;
+
+	JSON5_INSTRUMENT_GROWTH( filter, _sets );
+	_sets.resize( _numWords * 2 );
+	_program.start( set( 0 ) );
+	_program.close( set( 0 ) );
+	enter( root, 0 );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline filter_walker::filter_walker( const filter_program &program, const json5::value &node, const filter_program::word *set )
+	: _program( program )
+	, _numWords( program.num_words() )
+{
+	restart( node, set );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void filter_walker::restart( const json5::value &node, const filter_program::word *set )
+{
+	_stack.clear();
+	_split = json5::value();
+	_pendingState = size_t( -1 );
+
+	if ( !_numWords )
+		return;
+
+	JSON5_INSTRUMENT_GROWTH( filter, _sets );
+	if ( _sets.size() < _numWords * 2 )
+		_sets.resize( _numWords * 2 );
+
+	std::copy( set, set + _numWords, _sets.begin() );
+	enter( node, 0 );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_walker::next( json5::value &out, size_t &pattern )
+{
+	for ( ;; )
+	{
+		if ( _pendingState != size_t( -1 ) )
+		{
+			const word *s = set( _pendingSlot );
+
+			for ( size_t i = next_bit( s, _numWords, _pendingState ); i != size_t( -1 ); i = next_bit( s, _numWords, i + 1 ) )
 			{
-				auto first = head.front();
-				if ( ( first == '\'' || first == '"' ) && head.back() == first )
-					head = head.substr( 1, head.size() - 2 );
+				// Report each pattern once per value
+				if ( _program[i].pattern == _pendingPattern || !accepts( i, _pending ) )
+					continue;
+
+				_pendingState = i + 1;
+				_pendingPattern = _program[i].pattern;
+				out = _pending;
+				pattern = _pendingPattern;
+				return true;
 			}
 
-			for ( auto kvp : object_view( in ) )
+			_pendingState = size_t( -1 );
+		}
+
+		if ( _stack.empty() || split() )
+			return false;
+
+		auto &f = _stack.back();
+		json5::value child;
+		const char *key = nullptr;
+
+		if ( f.object )
+		{
+			if ( !( f.object_item != f.object_end ) )
 			{
-				if ( head == kvp.first )
-					filter( kvp.second, tail, std::forward<Func>( func ) );
+				_stack.pop_back();
+				continue;
 			}
+
+			auto kvp = *f.object_item;
+			++f.object_item;
+			key = kvp.first;
+			child = kvp.second;
+		}
+		else
+		{
+			if ( f.array_item == f.array_end )
+			{
+				_stack.pop_back();
+				continue;
+			}
+
+			child = *f.array_item++;
+			++f.array_index;
+		}
+
+		size_t slot = _stack.size();
+		if ( _sets.size() < ( slot + 1 ) * _numWords )
+		{
+			JSON5_INSTRUMENT_GROWTH( filter, _sets );
+			_sets.resize( ( slot + 1 ) * _numWords );
 		}
+
+		if ( step( slot - 1, f, key, child, slot ) )
+			enter( child, slot );
 	}
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline std::vector<json5::value> filter( const json5::value &in, std::string_view pattern )
+// Computes state set of a child (at 'childSlot') from state set of its container (at 'parentSlot')
+inline bool filter_walker::step( size_t parentSlot, const frame &parent, const char *key, const json5::value &child, size_t childSlot )
+{
+	size_t index = parent.object ? size_t( -1 ) : parent.array_index - 1;
+	return _program.transition( set( parentSlot ), set( childSlot ), key, index, parent.array_size, child );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_walker::accepts( size_t index, const json5::value &node ) const noexcept
+{
+	const auto &s = _program[index];
+
+	if ( s.type == filter_program::state::accept )
+		return true;
+
+	// '*' as the last segment matches a non-container value itself
+	return s.type == filter_program::state::any && _program[index + 1].type == filter_program::state::accept &&
+	       !node.is_object() && !node.is_array();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void filter_walker::enter( const json5::value &node, size_t slot )
+{
+	JSON5_INSTRUMENT_GROWTH( filter, _stack );
+
+	_pending = node;
+	_pendingSlot = slot;
+	_pendingState = 0;
+	_pendingPattern = size_t( -1 );
+
+	if ( !_program.consumes( set( slot ) ) )
+		return;
+
+	if ( node.is_object() )
+	{
+		auto obj = object_view( node );
+		auto &f = _stack.emplace_back();
+		f.object = true;
+		f.object_item = obj.begin();
+		f.object_end = obj.end();
+	}
+	else if ( node.is_array() )
+	{
+		auto arr = array_view( node );
+
+		// State set stays at 'slot' (the top of the stack) until 'resume'
+		if ( arr.size() > _splitSize )
+		{
+			_split = node;
+			return;
+		}
+
+		auto &f = _stack.emplace_back();
+		f.array_item = arr.begin();
+		f.array_end = arr.end();
+		f.array_size = arr.size();
+	}
+}
+
+} // namespace detail
+
+/*
+	Lazy range of filter matches. The document is traversed as the range is iterated, one match at a time,
+	so breaking out of the loop early skips the rest of the document. Single pass, the range can be iterated
+	only once. Both the document and the compiled pattern must outlive the range.
+
+	for ( auto v : json5::filter_range( doc, pattern ) )
+		if ( ... ) break;
+*/
+class filter_range final
+{
+public:
+	filter_range( const json5::value &in, const compiled_filter &pattern ) : _walker( pattern.program(), in ) { }
+
+	// Range owns a pattern compiled from string
+	filter_range( const json5::value &in, std::string_view pattern )
+		: _owned( std::make_unique<compiled_filter>( pattern ) )
+		, _walker( _owned->program(), in )
+	{
+	}
+
+	filter_range( const filter_range & ) = delete;
+	filter_range &operator=( const filter_range & ) = delete;
+
+	class iterator final
+	{
+	public:
+		iterator( filter_range *range = nullptr ) noexcept : _range( range ) { }
+		bool operator==( const iterator &other ) const noexcept { return _range == other._range; }
+		bool operator!=( const iterator &other ) const noexcept { return _range != other._range; }
+		iterator &operator++() { if ( !_range->advance() ) _range = nullptr; return *this; }
+		const json5::value &operator*() const noexcept { return _range->_current; }
+		const json5::value *operator->() const noexcept { return &_range->_current; }
+
+	private:
+		filter_range *_range = nullptr;
+	};
+
+	// Finds the first match
+	iterator begin() { return advance() ? iterator( this ) : iterator(); }
+	iterator end() noexcept { return iterator(); }
+
+private:
+	bool advance() { size_t patternIndex = 0; return _walker.next( _current, patternIndex ); }
+
+	std::unique_ptr<compiled_filter> _owned;
+	detail::filter_walker _walker;
+	json5::value _current;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Func>
+inline void filter( const json5::value &in, const compiled_filter &pattern, Func &&func )
+{
+	detail::filter_walker walker( pattern.program(), in );
+
+	json5::value match;
+	size_t patternIndex = 0;
+	while ( walker.next( match, patternIndex ) )
+		func( match );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Func>
+inline void filter( const json5::value &in, std::string_view pattern, Func &&func )
+{
+	filter( in, compiled_filter( pattern ), std::forward<Func>( func ) );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<json5::value> filter( const json5::value &in, const compiled_filter &pattern )
 {
 	std::vector<value> result;
-	filter( in, pattern, [&result]( const value & v ) { result.push_back( v ); } );
+	filter( in, pattern, [&result]( const value & v )
+	{
+		JSON5_INSTRUMENT_GROWTH( filter, result );
+		result.push_back( v );
+	} );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<json5::value> filter( const json5::value &in, std::string_view pattern )
+{
+	return filter( in, compiled_filter( pattern ) );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Func>
+inline void filter( const json5::value &in, const filter_set &patterns, Func &&func )
+{
+	detail::filter_walker walker( patterns.program(), in );
+
+	json5::value match;
+	size_t patternIndex = 0;
+	while ( walker.next( match, patternIndex ) )
+		func( patternIndex, match );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<std::vector<json5::value>> filter( const json5::value &in, const filter_set &patterns )
+{
+	std::vector<std::vector<value>> result( patterns.size() );
+	filter( in, patterns, [&result]( size_t index, const value & v )
+	{
+		JSON5_INSTRUMENT_GROWTH( filter, result[index] );
+		result[index].push_back( v );
+	} );
 	return result;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_first( const json5::value &in, const compiled_filter &pattern, json5::value &out )
+{
+	detail::filter_walker walker( pattern.program(), in );
+
+	size_t patternIndex = 0;
+	return walker.next( out, patternIndex );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool filter_first( const json5::value &in, std::string_view pattern, json5::value &out )
+{
+	return filter_first( in, compiled_filter( pattern ), out );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline size_t filter_count( const json5::value &in, const compiled_filter &pattern, size_t limit )
+{
+	detail::filter_walker walker( pattern.program(), in );
+
+	size_t count = 0;
+	json5::value match;
+	size_t patternIndex = 0;
+	while ( count < limit && walker.next( match, patternIndex ) )
+		++count;
+
+	return count;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline size_t filter_count( const json5::value &in, std::string_view pattern, size_t limit )
+{
+	return filter_count( in, compiled_filter( pattern ), limit );
+}
+
 } // namespace json5
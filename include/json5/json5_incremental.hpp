@@ -0,0 +1,358 @@
+#pragma once
+
+#include "json5_reflect.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace json5 {
+
+/*
+	Incremental serializer of a reflected type. Keeps the formatted text of every top-level member together with
+	a copy of its last written value. 'update' re-formats only members that compare different from that copy
+	and splices the cached text of the others, so repeated snapshots of a large object cost roughly as much as
+	the change between them. Members without a usable equality (e.g. nested types without 'operator==' or
+	reflection) are re-formatted on every update.
+
+	'patch' returns a JSON merge patch (RFC 7386) from the previous update to the last one. Reflected members and
+	maps are diffed key by key: removed map keys are written as 'null', unchanged keys are left out, and changed
+	keys are patched recursively. Everything else (arrays, numbers, strings, ...) is replaced as a whole. As in
+	RFC 7386, a member or map value that is itself written as 'null' reads as a removal when the patch is applied.
+
+	incremental_writer<State> snapshots;
+
+	snapshots.update( state );
+	send( snapshots.text() );  // Full text, same as json5::to_string( state )
+	send( snapshots.patch() ); // JSON merge patch (RFC 7386) from the previous update
+*/
+template <typename T>
+class incremental_writer final
+{
+public:
+	incremental_writer( const writer_params &wp = writer_params() ) : _params( wp ) { }
+
+	// Refreshes output from 'in', returns number of top-level members changed since the previous update
+	size_t update( const T &in );
+
+	// Full text written by the last update
+	const std::string &text() const noexcept { return _text; }
+
+	// JSON merge patch from the previous update to the last one, full text after the first update
+	std::string patch() const;
+
+	// Forget cached output, next update re-formats every member
+	void reset() noexcept { _members.clear(); }
+
+private:
+	struct member
+	{
+		std::string_view name;
+		std::string text;
+		std::string patch; // Merge patch of reflected and map members, other members are patched with 'text'
+		bool merged = false;
+		bool changed = false;
+	};
+
+	template <typename Member>
+	void update_member( size_t index, std::string_view name, const Member &in, Member &prev );
+
+	template <size_t Index, typename In, typename Prev>
+	void update_members( size_t index, const In &in, Prev &prev );
+
+	template <typename In, typename Prev, size_t... Is>
+	void update_members( size_t index, const json5::detail::name_table<sizeof...( Is )> &names, const In &in, Prev &prev, std::index_sequence<Is...> );
+
+	void write( bool changedOnly, std::string &out ) const;
+
+	writer_params _params;
+	T _prev = T();
+	std::vector<member> _members;
+	std::ostringstream _os;
+	std::string _text;
+	size_t _numChanged = 0;
+	bool _initialized = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template <typename T> bool deep_equal( const T &a, const T &b );
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline bool deep_equal_range( const T *a, const T *b, size_t numItems )
+{
+	for ( size_t i = 0; i < numItems; ++i )
+		if ( !deep_equal( a[i], b[i] ) )
+			return false;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename A>
+inline bool deep_equal( const std::vector<T, A> &a, const std::vector<T, A> &b )
+{
+	return a.size() == b.size() && deep_equal_range( a.data(), b.data(), a.size() );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline bool deep_equal( const std::array<T, N> &a, const std::array<T, N> &b )
+{
+	return deep_equal_range( a.data(), b.data(), N );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline bool deep_equal_map( const T &a, const T &b )
+{
+	if ( a.size() != b.size() )
+		return false;
+
+	for ( const auto &kvp : a )
+	{
+		auto iter = b.find( kvp.first );
+		if ( iter == b.end() || !deep_equal( kvp.second, iter->second ) )
+			return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename K, typename T, typename P, typename A>
+inline bool deep_equal( const std::map<K, T, P, A> &a, const std::map<K, T, P, A> &b ) { return deep_equal_map( a, b ); }
+
+template <typename K, typename T, typename H, typename EQ, typename A>
+inline bool deep_equal( const std::unordered_map<K, T, H, EQ, A> &a, const std::unordered_map<K, T, H, EQ, A> &b ) { return deep_equal_map( a, b ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Tuple, size_t... Is>
+inline bool deep_equal_tuple( const Tuple &a, const Tuple &b, std::index_sequence<Is...> )
+{
+	return ( deep_equal( std::get<Is>( a ), std::get<Is>( b ) ) && ... );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t Index = 0, typename... Types>
+inline bool deep_equal_named_tuple( const std::tuple<Types...> &a, const std::tuple<Types...> &b )
+{
+	const auto &members = std::get < Index + 1 > ( a );
+	constexpr size_t numMembers = std::tuple_size_v<std::remove_reference_t<decltype( members )>>;
+
+	if ( !deep_equal_tuple( members, std::get < Index + 1 > ( b ), std::make_index_sequence<numMembers>() ) )
+		return false;
+
+	if constexpr ( Index + 2 != sizeof...( Types ) )
+		return deep_equal_named_tuple < Index + 2 > ( a, b );
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Compares values member by member, types that can't be compared are reported as different
+template <typename T>
+inline bool deep_equal( const T &a, const T &b )
+{
+	if constexpr ( std::is_array_v<T> )
+		return deep_equal_range( a, b, std::extent_v<T> );
+	else if constexpr ( is_reflected_v<T> )
+		return deep_equal_named_tuple( class_wrapper<T>::make_named_tuple( a ), class_wrapper<T>::make_named_tuple( b ) );
+	else if constexpr ( std::equality_comparable<T> )
+		return a == b;
+	else
+		return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void deep_assign( T &out, const T &in )
+{
+	if constexpr ( std::is_array_v<T> )
+	{
+		for ( size_t i = 0; i < std::extent_v<T>; ++i )
+			deep_assign( out[i], in[i] );
+	}
+	else
+		out = in;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T> struct is_map : std::false_type { };
+template <typename K, typename T, typename P, typename A> struct is_map<std::map<K, T, P, A>> : std::true_type { };
+template <typename K, typename T, typename H, typename EQ, typename A> struct is_map<std::unordered_map<K, T, H, EQ, A>> : std::true_type { };
+
+// Types written as JSON objects with known keys, which a merge patch diffs key by key
+template <typename T> constexpr bool is_merge_object_v = is_map<T>::value || is_reflected_v<T>;
+
+template <typename T> void write_merge_patch( stream_writer &w, const T &prev, const T &in );
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void write_merge_patch_map( stream_writer &w, const T &prev, const T &in )
+{
+	w.begin_object();
+
+	for ( const auto &kvp : prev )
+		if ( in.find( kvp.first ) == in.end() )
+			w.key( kvp.first ).null();
+
+	for ( const auto &kvp : in )
+	{
+		if ( auto iter = prev.find( kvp.first ); iter == prev.end() )
+			write( w.key( kvp.first ), kvp.second );
+		else if ( !deep_equal( iter->second, kvp.second ) )
+			write_merge_patch( w.key( kvp.first ), iter->second, kvp.second );
+	}
+
+	w.end_object();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t N, typename Tuple, size_t... Is>
+inline void write_merge_patch_tuple( stream_writer &w, const name_table<N> &names, const Tuple &prev, const Tuple &in, std::index_sequence<Is...> )
+{
+	( ( names[Is].empty() || deep_equal( std::get<Is>( prev ), std::get<Is>( in ) ) ||
+	    ( write_merge_patch( w.key( names[Is] ), std::get<Is>( prev ), std::get<Is>( in ) ), true ) ), ... );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t Index = 0, typename... Types>
+inline void write_merge_patch_named_tuple( stream_writer &w, const std::tuple<Types...> &prev, const std::tuple<Types...> &in )
+{
+	const auto &members = std::get < Index + 1 > ( in );
+	constexpr size_t numMembers = std::tuple_size_v<std::remove_reference_t<decltype( members )>>;
+
+	write_merge_patch_tuple( w, *std::get<Index>( in ), std::get < Index + 1 > ( prev ), members, std::make_index_sequence<numMembers>() );
+
+	if constexpr ( Index + 2 != sizeof...( Types ) )
+		write_merge_patch_named_tuple < Index + 2 > ( w, prev, in );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Writes the members of 'in' that differ from 'prev', values that are not objects are written whole
+template <typename T>
+inline void write_merge_patch( stream_writer &w, const T &prev, const T &in )
+{
+	if constexpr ( is_map<T>::value )
+		write_merge_patch_map( w, prev, in );
+	else if constexpr ( is_reflected_v<T> )
+	{
+		w.begin_object();
+		write_merge_patch_named_tuple( w, class_wrapper<T>::make_named_tuple( prev ), class_wrapper<T>::make_named_tuple( in ) );
+		w.end_object();
+	}
+	else
+		write( w, in );
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline size_t incremental_writer<T>::update( const T &in )
+{
+	_initialized = !_members.empty();
+	_numChanged = 0;
+
+	auto inTuple = json5::detail::class_wrapper<T>::make_named_tuple( in );
+	auto prevTuple = json5::detail::class_wrapper<T>::make_named_tuple( _prev );
+	update_members<0>( 0, inTuple, prevTuple );
+
+	write( false, _text );
+	return _numChanged;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+template <typename Member>
+inline void incremental_writer<T>::update_member( size_t index, std::string_view name, const Member &in, Member &prev )
+{
+	if ( _members.size() <= index )
+		_members.resize( index + 1 );
+
+	auto &m = _members[index];
+	m.name = name;
+	m.changed = !_initialized || !json5::detail::deep_equal( in, prev );
+
+	if ( !m.changed || name.empty() )
+		return;
+
+	// Format at depth 1, so the text can be placed under its key in the enclosing object as is
+	_os.str( std::string() );
+	stream_writer w( _os, _params, 1 );
+	json5::detail::write( w, in );
+	m.text = _os.str();
+
+	m.merged = false;
+	if constexpr ( json5::detail::is_merge_object_v<Member> )
+	{
+		if ( _initialized )
+		{
+			_os.str( std::string() );
+			stream_writer pw( _os, _params, 1 );
+			json5::detail::write_merge_patch( pw, prev, in );
+			m.patch = _os.str();
+			m.merged = true;
+		}
+	}
+
+	json5::detail::deep_assign( prev, in );
+	++_numChanged;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+template <size_t Index, typename In, typename Prev>
+inline void incremental_writer<T>::update_members( size_t index, const In &in, Prev &prev )
+{
+	const auto &members = std::get < Index + 1 > ( in );
+	constexpr size_t numMembers = std::tuple_size_v<std::remove_reference_t<decltype( members )>>;
+
+	update_members( index, *std::get<Index>( in ), members, std::get < Index + 1 > ( prev ), std::make_index_sequence<numMembers>() );
+
+	if constexpr ( Index + 2 != std::tuple_size_v<In> )
+		update_members < Index + 2 > ( index + numMembers, in, prev );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+template <typename In, typename Prev, size_t... Is>
+inline void incremental_writer<T>::update_members( size_t index, const json5::detail::name_table<sizeof...( Is )> &names, const In &in, Prev &prev, std::index_sequence<Is...> )
+{
+	( update_member( index + Is, names[Is], std::get<Is>( in ), std::get<Is>( prev ) ), ... );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline std::string incremental_writer<T>::patch() const
+{
+	std::string result;
+	write( true, result );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void incremental_writer<T>::write( bool changedOnly, std::string &out ) const
+{
+	std::ostringstream os;
+	stream_writer w( os, _params );
+
+	w.begin_object();
+
+	for ( const auto &m : _members )
+		if ( !m.name.empty() && ( m.changed || !changedOnly ) )
+			w.key( m.name ).raw_value( ( changedOnly && m.merged ) ? m.patch : m.text );
+
+	w.end_object();
+
+	out = os.str();
+}
+
+} // namespace json5
@@ -2,14 +2,18 @@
 
 #include "json5_builder.hpp"
 
-#if __has_include(<xcharconv>)
+#if __has_include(<charconv>)
 	#include <charconv>
-	#if !defined(_JSON5_HAS_CHARCONV)
+	#if !defined(_JSON5_HAS_CHARCONV) && ( __has_include(<xcharconv>) || defined(__cpp_lib_to_chars) )
 		#define _JSON5_HAS_CHARCONV
 	#endif
 #endif
 
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <sstream>
 
 namespace json5 {
@@ -23,38 +27,74 @@ error from_string( const std::string &str, document &doc );
 // Parse json5::document from file
 error from_file( const std::string &fileName, document &doc );
 
+// Parse json5::document from memory, reusing scratch buffers of 'context'
+error from_string( std::string_view str, document &doc, parse_context &context );
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-class parser final : builder
+namespace detail {
+
+/*
+
+json5::detail::tokenizer
+
+Splits JSON5 text from a char_source into tokens. Strings and identifiers are appended (zero terminated)
+into the provided string buffer.
+
+*/
+class tokenizer
 {
 public:
-	parser( document &doc, detail::char_source &chars ) : builder( doc ), _chars( chars ) { }
+	tokenizer( char_source &chars, std::string &strings ) : _chars( chars ), _strings( strings ) { }
 
-	error parse();
+	enum class token_type
+	{
+		unknown, identifier, string, number, colon, comma,
+		object_begin, object_end, array_begin, array_end,
+		literal_true, literal_false, literal_null, literal_infinity, literal_nan
+	};
 
-private:
 	int next() { return _chars.next(); }
 	int peek() { return _chars.peek(); }
 	bool eof() const { return _chars.eof(); }
 	error make_error( int type ) const noexcept { return _chars.make_error( type ); }
 
-	enum class token_type
+	error peek_next_token( token_type &result );
+	error parse_number( double &result );
+	error parse_string( string_offset &result );
+	error parse_identifier( string_offset &result );
+	error parse_literal( token_type &result );
+
+protected:
+	char_source &_chars;
+	std::string &_strings;
+};
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class parser final : builder, detail::tokenizer
+{
+public:
+	parser( document &doc, detail::char_source &chars ) : builder( doc ), detail::tokenizer( chars, string_buffer() ) { }
+
+	parser( document &doc, detail::char_source &chars, parse_context &context )
+		: builder( doc, context )
+		, detail::tokenizer( chars, string_buffer() )
 	{
-		unknown, identifier, string, number, colon, comma,
-		object_begin, object_end, array_begin, array_end,
-		literal_true, literal_false, literal_null
-	};
+	}
+
+	// Parse document, root must be an object or an array
+	error parse();
+
+	// Parse a single value of any type and store it as the only element of a root array
+	error parse_element();
 
+private:
 	error parse_value( value &result );
 	error parse_object();
 	error parse_array();
-	error peek_next_token( token_type &result );
-	error parse_number( double &result );
-	error parse_string( detail::string_offset &result );
-	error parse_identifier( detail::string_offset &result );
-	error parse_literal( token_type &result );
-
-	detail::char_source &_chars;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -75,6 +115,7 @@ public:
 		}
 
 		++_column;
+		JSON5_INSTRUMENT_COUNT( bytes, 1 );
 		return _is.get();
 	}
 
@@ -86,6 +127,78 @@ protected:
 	std::istream &_is;
 };
 
+class memory_source final : public char_source
+{
+public:
+	memory_source( std::string_view str ) : _cursor( str.data() ), _end( str.data() + str.size() ) { }
+
+	int next() override
+	{
+		if ( _cursor == _end )
+			return -1;
+
+		if ( *_cursor == '\n' )
+		{
+			_column = 0;
+			++_line;
+		}
+
+		++_column;
+		JSON5_INSTRUMENT_COUNT( bytes, 1 );
+		return uint8_t( *_cursor++ );
+	}
+
+	int peek() override { return _cursor != _end ? uint8_t( *_cursor ) : -1; }
+
+	bool eof() const override { return _cursor == _end; }
+
+private:
+	const char *_cursor;
+	const char *_end;
+};
+
+/*
+
+json5::detail::stream_reader
+
+Pulls values from JSON5 text one at a time, without building a json5::document. Used by reflection
+to read directly into C++ objects. String views returned by 'read_string' and 'next_key' are valid
+until the next string or key is read.
+
+*/
+class stream_reader final : public tokenizer
+{
+public:
+	stream_reader( char_source &chars ) : tokenizer( chars, _buffer ) { }
+
+	error read_bool( bool &result );
+	error read_number( double &result );
+	error read_string( std::string_view &result );
+
+	// Consume '{' (or 'null' literal, if 'isNull' is provided)
+	error begin_object( bool *isNull = nullptr );
+
+	// Consume '[' (or 'null' literal, if 'isNull' is provided)
+	error begin_array( bool *isNull = nullptr );
+
+	// Read next object key (with ':'), 'done' is set when '}' is consumed instead
+	error next_key( size_t index, std::string_view &key, bool &done );
+
+	// Move to next array item, 'done' is set when ']' is consumed instead
+	error next_item( size_t index, bool &done );
+
+	// Parse and discard next value
+	error skip_value();
+
+	// Parse next value into a document, as the only element of a root array
+	error parse_element( document &doc );
+
+private:
+	error begin_container( token_type expected, int errorType, bool *isNull );
+
+	std::string _buffer;
+};
+
 } // namespace detail
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -104,9 +217,26 @@ inline error parser::parse()
 	return { error::none };
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline error parser::parse_element()
+{
+	reset();
+	push_array();
+
+	value newValue;
+	if ( auto err = parse_value( newValue ) )
+		return err;
+
+	( *this ) += newValue;
+	pop();
+	return { error::none };
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 inline error parser::parse_value( value &result )
 {
+	JSON5_INSTRUMENT_COUNT( values, 1 );
+
 	token_type tt = token_type::unknown;
 	if ( auto err = peek_next_token( tt ) )
 		return err;
@@ -143,6 +273,10 @@ inline error parser::parse_value( value &result )
 					result = value( false );
 				else if ( lit == token_type::literal_null )
 					result = value();
+				else if ( lit == token_type::literal_infinity )
+					result = value( std::numeric_limits<double>::infinity() );
+				else if ( lit == token_type::literal_nan )
+					result = value( std::numeric_limits<double>::quiet_NaN() );
 				else
 					return make_error( error::invalid_literal );
 			}
@@ -277,8 +411,10 @@ inline error parser::parse_array()
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline error parser::peek_next_token( token_type &result )
+inline error detail::tokenizer::peek_next_token( token_type &result )
 {
+	JSON5_INSTRUMENT_PHASE( tokenize );
+
 	enum class comment_type { none, line, block } parsingComment = comment_type::none;
 
 	while ( !eof() )
@@ -350,8 +486,10 @@ inline error parser::peek_next_token( token_type &result )
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline error parser::parse_number( double &result )
+inline error detail::tokenizer::parse_number( double &result )
 {
+	JSON5_INSTRUMENT_PHASE( tokenize );
+
 	char buff[256] = { };
 	size_t length = 0;
 
@@ -377,18 +515,25 @@ inline error parser::parse_number( double &result )
 		return make_error( error::syntax_error );
 #endif
 
+	// "-NaN" would set bits json5::value uses to tag its types
+	if ( result != result )
+		result = std::numeric_limits<double>::quiet_NaN();
+
 	return { error::none };
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline error parser::parse_string( detail::string_offset &result )
+inline error detail::tokenizer::parse_string( detail::string_offset &result )
 {
+	JSON5_INSTRUMENT_PHASE( tokenize );
+	JSON5_INSTRUMENT_GROWTH( document, _strings );
+
 	static const constexpr char *hexChars = "0123456789abcdefABCDEF";
 
 	bool singleQuoted = peek() == '\'';
 	next(); // Consume '\'' or '"'
 
-	result = string_buffer_offset();
+	result = detail::string_offset( _strings.size() );
 
 	while ( !eof() )
 	{
@@ -401,25 +546,25 @@ inline error parser::parse_string( detail::string_offset &result )
 			if ( ch == '\n' || ch == 'v' || ch == 'f' )
 				next();
 			else if ( ch == 't' && next() )
-				string_buffer_add( '\t' );
+				_strings.push_back( '\t' );
 			else if ( ch == 'n' && next() )
-				string_buffer_add( '\n' );
+				_strings.push_back( '\n' );
 			else if ( ch == 'r' && next() )
-				string_buffer_add( '\r' );
+				_strings.push_back( '\r' );
 			else if ( ch == 'b' && next() )
-				string_buffer_add( '\b' );
+				_strings.push_back( '\b' );
 			else if ( ch == '\\' && next() )
-				string_buffer_add( '\\' );
+				_strings.push_back( '\\' );
 			else if ( ch == '\'' && next() )
-				string_buffer_add( '\'' );
+				_strings.push_back( '\'' );
 			else if ( ch == '"' && next() )
-				string_buffer_add( '"' );
+				_strings.push_back( '"' );
 			else if ( ch == '\\' && next() )
-				string_buffer_add( '\\' );
+				_strings.push_back( '\\' );
 			else if ( ch == '/' && next() )
-				string_buffer_add( '/' );
+				_strings.push_back( '/' );
 			else if ( ch == '0' && next() )
-				string_buffer_add( 0 );
+				_strings.push_back( 0 );
 			else if ( ( ch == 'x' || ch == 'u' ) && next() )
 			{
 				char code[5] = { };
@@ -440,26 +585,29 @@ inline error parser::parse_string( detail::string_offset &result )
 					return make_error( error::invalid_escape_seq );
 #endif
 
-				string_buffer_add_utf8( uint32_t( unicodeChar ) );
+				detail::append_utf8( _strings, uint32_t( unicodeChar ) );
 			}
 			else
 				return make_error( error::invalid_escape_seq );
 		}
 		else
-			string_buffer_add( next() );
+			_strings.push_back( char( next() ) );
 	}
 
 	if ( eof() )
 		return make_error( error::unexpected_end );
 
-	string_buffer_add( 0 );
+	_strings.push_back( 0 );
 	return { error::none };
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline error parser::parse_identifier( detail::string_offset &result )
+inline error detail::tokenizer::parse_identifier( detail::string_offset &result )
 {
-	result = string_buffer_offset();
+	JSON5_INSTRUMENT_PHASE( tokenize );
+	JSON5_INSTRUMENT_GROWTH( document, _strings );
+
+	result = detail::string_offset( _strings.size() );
 
 	int firstCh = peek();
 	bool isString = ( firstCh == '\'' ) || ( firstCh == '"' );
@@ -473,7 +621,7 @@ inline error parser::parse_identifier( detail::string_offset &result )
 
 	while ( !eof() )
 	{
-		string_buffer_add( next() );
+		_strings.push_back( char( next() ) );
 
 		int ch = peek();
 		if ( !isalpha( ch ) && !isdigit( ch ) && ch != '_' )
@@ -483,13 +631,15 @@ inline error parser::parse_identifier( detail::string_offset &result )
 	if ( isString && firstCh != next() ) // Consume '\'' or '"'
 		return make_error( error::syntax_error );
 
-	string_buffer_add( 0 );
+	_strings.push_back( 0 );
 	return { error::none };
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline error parser::parse_literal( token_type &result )
+inline error detail::tokenizer::parse_literal( token_type &result )
 {
+	JSON5_INSTRUMENT_PHASE( tokenize );
+
 	int ch = peek();
 
 	// "true"
@@ -519,15 +669,293 @@ inline error parser::parse_literal( token_type &result )
 			return { error::none };
 		}
 	}
+	// "Infinity" (signed forms are parsed as numbers)
+	else if ( ch == 'I' )
+	{
+		if ( next() && next() == 'n' && next() == 'f' && next() == 'i' && next() == 'n' && next() == 'i' && next() == 't' && next() == 'y' )
+		{
+			result = token_type::literal_infinity;
+			return { error::none };
+		}
+	}
+	// "NaN"
+	else if ( ch == 'N' )
+	{
+		if ( next() && next() == 'a' && next() == 'N' )
+		{
+			result = token_type::literal_nan;
+			return { error::none };
+		}
+	}
 
 	return make_error( error::invalid_literal );
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::read_bool( bool &result )
+{
+	token_type tt = token_type::unknown;
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	if ( tt != token_type::identifier )
+		return make_error( error::boolean_expected );
+
+	if ( auto err = parse_literal( tt ) )
+		return err;
+
+	if ( tt != token_type::literal_true && tt != token_type::literal_false )
+		return make_error( error::boolean_expected );
+
+	result = tt == token_type::literal_true;
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::read_number( double &result )
+{
+	token_type tt = token_type::unknown;
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	if ( tt == token_type::identifier )
+	{
+		if ( auto err = parse_literal( tt ) )
+			return err;
+
+		if ( tt == token_type::literal_infinity )
+			result = std::numeric_limits<double>::infinity();
+		else if ( tt == token_type::literal_nan )
+			result = std::numeric_limits<double>::quiet_NaN();
+		else
+			return make_error( error::number_expected );
+
+		return { error::none };
+	}
+
+	if ( tt != token_type::number )
+		return make_error( error::number_expected );
+
+	return parse_number( result );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::read_string( std::string_view &result )
+{
+	token_type tt = token_type::unknown;
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	if ( tt != token_type::string )
+		return make_error( error::string_expected );
+
+	_buffer.clear();
+
+	string_offset offset = 0;
+	if ( auto err = parse_string( offset ) )
+		return err;
+
+	result = std::string_view( _buffer.data(), _buffer.size() - 1 );
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::begin_object( bool *isNull )
+{
+	return begin_container( token_type::object_begin, error::object_expected, isNull );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::begin_array( bool *isNull )
+{
+	return begin_container( token_type::array_begin, error::array_expected, isNull );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::begin_container( token_type expected, int errorType, bool *isNull )
+{
+	token_type tt = token_type::unknown;
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	if ( isNull )
+		*isNull = false;
+
+	if ( tt == expected )
+	{
+		next(); // Consume '{' or '['
+		return { error::none };
+	}
+
+	if ( tt == token_type::identifier && isNull )
+	{
+		if ( auto err = parse_literal( tt ) )
+			return err;
+
+		if ( tt == token_type::literal_null )
+		{
+			*isNull = true;
+			return { error::none };
+		}
+	}
+
+	return make_error( errorType );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::next_key( size_t index, std::string_view &key, bool &done )
+{
+	token_type tt = token_type::unknown;
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	if ( index > 0 && tt != token_type::object_end )
+	{
+		if ( tt != token_type::comma )
+			return make_error( error::comma_expected );
+
+		next(); // Consume ','
+
+		if ( auto err = peek_next_token( tt ) )
+			return err;
+	}
+
+	if ( ( done = ( tt == token_type::object_end ) ) )
+	{
+		next(); // Consume '}'
+		return { error::none };
+	}
+
+	if ( tt != token_type::identifier && tt != token_type::string )
+		return make_error( error::syntax_error );
+
+	_buffer.clear();
+
+	string_offset offset = 0;
+	if ( auto err = parse_identifier( offset ) )
+		return err;
+
+	key = std::string_view( _buffer.data(), _buffer.size() - 1 );
+
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	if ( tt != token_type::colon )
+		return make_error( error::colon_expected );
+
+	next(); // Consume ':'
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::next_item( size_t index, bool &done )
+{
+	token_type tt = token_type::unknown;
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	if ( index > 0 && tt != token_type::array_end )
+	{
+		if ( tt != token_type::comma )
+			return make_error( error::comma_expected );
+
+		next(); // Consume ','
+
+		if ( auto err = peek_next_token( tt ) )
+			return err;
+	}
+
+	if ( ( done = ( tt == token_type::array_end ) ) )
+		next(); // Consume ']'
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::skip_value()
+{
+	token_type tt = token_type::unknown;
+	if ( auto err = peek_next_token( tt ) )
+		return err;
+
+	switch ( tt )
+	{
+		case token_type::number:
+		{
+			double number = 0.0;
+			return parse_number( number );
+		}
+
+		case token_type::string:
+		{
+			std::string_view str;
+			return read_string( str );
+		}
+
+		case token_type::identifier:
+		{
+			if ( auto err = parse_literal( tt ) )
+				return err;
+
+			return { error::none };
+		}
+
+		case token_type::object_begin:
+		{
+			next(); // Consume '{'
+
+			std::string_view key;
+			for ( size_t i = 0; ; ++i )
+			{
+				bool done = false;
+				if ( auto err = next_key( i, key, done ) )
+					return err;
+
+				if ( done )
+					return { error::none };
+
+				if ( auto err = skip_value() )
+					return err;
+			}
+		}
+
+		case token_type::array_begin:
+		{
+			next(); // Consume '['
+
+			for ( size_t i = 0; ; ++i )
+			{
+				bool done = false;
+				if ( auto err = next_item( i, done ) )
+					return err;
+
+				if ( done )
+					return { error::none };
+
+				if ( auto err = skip_value() )
+					return err;
+			}
+		}
+
+		default:
+			return make_error( error::syntax_error );
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error detail::stream_reader::parse_element( document &doc )
+{
+	parser p( doc, _chars );
+	return p.parse_element();
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //---------------------------------------------------------------------------------------------------------------------
 inline error from_stream( std::istream &is, document &doc )
 {
+	JSON5_INSTRUMENT_SCOPE( parse );
+
 	detail::stl_istream src( is );
 	parser r( doc, src );
 	return r.parse();
@@ -540,6 +968,16 @@ inline error from_string( const std::string &str, document &doc )
 	return from_stream( is, doc );
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline error from_string( std::string_view str, document &doc, parse_context &context )
+{
+	JSON5_INSTRUMENT_SCOPE( parse );
+
+	detail::memory_source src( str );
+	parser r( doc, src, context );
+	return r.parse();
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 inline error from_file( const std::string &fileName, document &doc )
 {
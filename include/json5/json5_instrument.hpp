@@ -0,0 +1,530 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+/*
+	Opt-in instrumentation of parsing and writing. Define JSON5_INSTRUMENTATION (for all translation units)
+	to compile the hooks in, otherwise all JSON5_INSTRUMENT_* macros expand to nothing. JSON5_ALLOCATION_TRACKING
+	compiles in only the (cheaper) allocation hooks used by 'allocation_tracker'.
+
+	Each top-level call (from_string, from_stream, to_stream, ...) made while a sink is installed fills one
+	'instrument_stats' and passes it to the sink. Nested calls are accounted to the outermost one, including
+	work which parallel calls (to_string_parallel) hand to worker threads.
+	Timing individual tokens costs two clock reads per token, so expect the instrumented parse to be slower.
+*/
+
+namespace json5 {
+
+//---------------------------------------------------------------------------------------------------------------------
+struct instrument_stats
+{
+	enum operation_type : uint8_t { parse, write };
+	operation_type operation = parse;
+
+	// Durations in nanoseconds. Parse time spent outside of 'tokenize' and 'relink' is reported as 'build'.
+	uint64_t total_ns = 0;
+	uint64_t tokenize_ns = 0;
+	uint64_t build_ns = 0;
+	uint64_t relink_ns = 0;
+	uint64_t write_ns = 0;
+
+	// Bytes read or written (when the stream position is available)
+	uint64_t bytes = 0;
+
+	// Values parsed or written, containers included
+	uint64_t values = 0;
+
+	// Deepest nesting of containers
+	uint32_t max_depth = 0;
+
+	// Allocations made by the library (see 'allocation_tracker')
+	uint64_t allocations = 0;
+};
+
+/*
+	Receives stats of instrumented calls. 'record' is called on the thread which made the call,
+	possibly from multiple threads at once.
+*/
+class instrument_sink
+{
+public:
+	virtual ~instrument_sink() = default;
+	virtual void record( const instrument_stats &stats ) = 0;
+};
+
+// Installs sink for all threads, nullptr disables instrumentation
+void set_instrument_sink( instrument_sink *sink ) noexcept;
+
+//
+instrument_sink *get_instrument_sink() noexcept;
+
+// Where the library allocates memory
+enum class allocation_site : uint8_t
+{
+	document, // Value and string buffers of documents (and string buffers of the direct reader)
+	builder,  // Stacks of builders and parsers
+	compare,  // Sorted key arrays of objects with many keys compared by 'object_view::operator=='
+	filter,   // Walker stacks and result vectors of filters
+	output,   // Output strings and nesting stacks of writers
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+struct allocation_counts
+{
+	static constexpr size_t num_sites = 5;
+
+	std::array<uint64_t, num_sites> count = {};
+	std::array<uint64_t, num_sites> bytes = {};
+
+	uint64_t operator[]( allocation_site site ) const noexcept { return count[size_t( site )]; }
+	uint64_t total() const noexcept;
+	uint64_t total_bytes() const noexcept;
+};
+
+/*
+	Counts allocations made by the library on the current thread, while it is alive. Trackers may be nested,
+	counts of an inner tracker are also added to the outer one. Counts stay zero unless JSON5_INSTRUMENTATION
+	or JSON5_ALLOCATION_TRACKING is defined.
+
+	Growth of library owned buffers (documents, builders, filter results, output strings) is counted with
+	the new capacity as size, allocations made inside the standard library streams are not visible.
+*/
+class allocation_tracker final
+{
+public:
+	allocation_tracker() noexcept;
+	~allocation_tracker();
+
+	allocation_tracker( const allocation_tracker & ) = delete;
+	allocation_tracker &operator=( const allocation_tracker & ) = delete;
+
+	const allocation_counts &counts() const noexcept { return _counts; }
+	uint64_t operator[]( allocation_site site ) const noexcept { return _counts[site]; }
+	uint64_t total() const noexcept { return _counts.total(); }
+
+private:
+	allocation_counts _counts;
+	allocation_counts *_parent;
+};
+
+/*
+	Thread safe histogram with power of two buckets, bucket 'i' counts samples in [2^(i-1), 2^i).
+*/
+class histogram final
+{
+public:
+	static constexpr size_t num_buckets = 65;
+
+	void add( uint64_t sample ) noexcept;
+
+	uint64_t count() const noexcept { return _count.load( std::memory_order_relaxed ); }
+	uint64_t sum() const noexcept { return _sum.load( std::memory_order_relaxed ); }
+	uint64_t max() const noexcept { return _max.load( std::memory_order_relaxed ); }
+	uint64_t bucket( size_t index ) const noexcept { return _buckets[index].load( std::memory_order_relaxed ); }
+
+	// Upper bound of the bucket containing quantile 'q' (0..1)
+	uint64_t quantile( double q ) const noexcept;
+
+private:
+	std::array<std::atomic<uint64_t>, num_buckets> _buckets = {};
+	std::atomic<uint64_t> _count = 0;
+	std::atomic<uint64_t> _sum = 0;
+	std::atomic<uint64_t> _max = 0;
+};
+
+/*
+	Sink aggregating stats into histograms, per operation.
+*/
+class histogram_sink final : public instrument_sink
+{
+public:
+	struct operation_histograms
+	{
+		histogram total_ns, tokenize_ns, build_ns, relink_ns, write_ns;
+		histogram bytes, values, max_depth, allocations;
+	};
+
+	void record( const instrument_stats &stats ) override;
+
+	const operation_histograms &parse() const noexcept { return _parse; }
+	const operation_histograms &write() const noexcept { return _write; }
+
+private:
+	operation_histograms _parse, _write;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+inline std::atomic<instrument_sink *> instrument_sink_ptr = nullptr;
+
+// Stats of the outermost instrumented call on this thread
+inline thread_local instrument_stats *instrument_current = nullptr;
+
+// Counts of the innermost allocation tracker on this thread
+inline thread_local allocation_counts *allocation_current = nullptr;
+
+//---------------------------------------------------------------------------------------------------------------------
+inline uint64_t instrument_now() noexcept
+{
+	return uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+/*
+	Collects stats of one call, passes them to the sink when destroyed
+*/
+class instrument_scope final
+{
+public:
+	instrument_scope( instrument_stats::operation_type operation ) noexcept
+	{
+		if ( instrument_current || !( _sink = instrument_sink_ptr.load( std::memory_order_acquire ) ) )
+			return;
+
+		_stats.operation = operation;
+		_start = instrument_now();
+		instrument_current = &_stats;
+	}
+
+	~instrument_scope()
+	{
+		if ( instrument_current != &_stats )
+			return;
+
+		instrument_current = nullptr;
+		_stats.total_ns = instrument_now() - _start;
+
+		if ( _stats.operation == instrument_stats::parse )
+			_stats.build_ns = _stats.total_ns - std::min( _stats.total_ns, _stats.tokenize_ns + _stats.relink_ns );
+		else
+			_stats.write_ns = _stats.total_ns;
+
+		_sink->record( _stats );
+	}
+
+	instrument_scope( const instrument_scope & ) = delete;
+	instrument_scope &operator=( const instrument_scope & ) = delete;
+
+private:
+	instrument_sink *_sink = nullptr;
+	instrument_stats _stats;
+	uint64_t _start = 0;
+};
+
+/*
+	Stats of the current call on this thread, shared with the workers of a parallel operation
+*/
+struct instrument_fork final
+{
+	instrument_stats *parent = instrument_current;
+	std::mutex mutex;
+};
+
+/*
+	Collects stats of work done on a worker thread for a forked call. Values, allocations and depth (nested
+	in 'baseDepth' levels of the call's output) are merged into the stats of the call when destroyed.
+	Bytes and time are left to the call itself.
+*/
+class instrument_worker final
+{
+public:
+	instrument_worker( instrument_fork &fork, size_t baseDepth ) noexcept
+		: _fork( fork )
+		, _prev( instrument_current )
+		, _baseDepth( uint32_t( baseDepth ) )
+	{
+		if ( _fork.parent )
+			instrument_current = &_stats;
+	}
+
+	~instrument_worker()
+	{
+		if ( !_fork.parent )
+			return;
+
+		instrument_current = _prev;
+
+		std::lock_guard lock( _fork.mutex );
+		_fork.parent->values += _stats.values;
+		_fork.parent->allocations += _stats.allocations;
+
+		if ( _stats.max_depth > 0 )
+			_fork.parent->max_depth = std::max( _fork.parent->max_depth, _baseDepth + _stats.max_depth );
+	}
+
+	instrument_worker( const instrument_worker & ) = delete;
+	instrument_worker &operator=( const instrument_worker & ) = delete;
+
+private:
+	instrument_fork &_fork;
+	instrument_stats *_prev;
+	instrument_stats _stats;
+	uint32_t _baseDepth;
+};
+
+/*
+	Adds time spent in its scope to a duration field of the current stats
+*/
+class instrument_phase final
+{
+public:
+	instrument_phase( uint64_t instrument_stats::*field ) noexcept
+		: _stats( instrument_current )
+		, _field( field )
+		, _start( _stats ? instrument_now() : 0 )
+	{
+	}
+
+	~instrument_phase()
+	{
+		if ( _stats )
+			_stats->*_field += instrument_now() - _start;
+	}
+
+	instrument_phase( const instrument_phase & ) = delete;
+	instrument_phase &operator=( const instrument_phase & ) = delete;
+
+private:
+	instrument_stats *_stats;
+	uint64_t instrument_stats::*_field;
+	uint64_t _start;
+};
+
+/*
+	Adds number of bytes written to 'os' in its scope to the current stats, if the stream position is known
+*/
+template <typename Stream>
+class instrument_output final
+{
+public:
+	instrument_output( Stream &os ) : _os( instrument_current ? &os : nullptr ), _start( _os ? int64_t( os.tellp() ) : -1 ) { }
+
+	~instrument_output()
+	{
+		if ( auto *stats = instrument_current; stats && _start >= 0 )
+			if ( auto end = int64_t( _os->tellp() ); end >= _start )
+				stats->bytes += uint64_t( end - _start );
+	}
+
+	instrument_output( const instrument_output & ) = delete;
+	instrument_output &operator=( const instrument_output & ) = delete;
+
+private:
+	Stream *_os;
+	int64_t _start;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void track_allocation( allocation_site site, uint64_t count, uint64_t bytes ) noexcept
+{
+	if ( auto *stats = instrument_current )
+		stats->allocations += count;
+
+	if ( auto *counts = allocation_current )
+	{
+		counts->count[size_t( site )] += count;
+		counts->bytes[size_t( site )] += bytes;
+	}
+}
+
+/*
+	Counts a reallocation, if capacity of a container changed in its scope
+*/
+template <typename Container>
+class instrument_growth final
+{
+public:
+	instrument_growth( allocation_site site, const Container &c ) noexcept : _container( c ), _capacity( c.capacity() ), _site( site ) { }
+
+	~instrument_growth()
+	{
+		if ( auto capacity = _container.capacity(); capacity != _capacity )
+			track_allocation( _site, 1, capacity * sizeof( typename Container::value_type ) );
+	}
+
+	instrument_growth( const instrument_growth & ) = delete;
+	instrument_growth &operator=( const instrument_growth & ) = delete;
+
+private:
+	const Container &_container;
+	size_t _capacity;
+	allocation_site _site;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void instrument_count( uint64_t instrument_stats::*field, uint64_t count ) noexcept
+{
+	if ( auto *stats = instrument_current )
+		stats->*field += count;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void instrument_depth( size_t depth ) noexcept
+{
+	if ( auto *stats = instrument_current; stats && depth > stats->max_depth )
+		stats->max_depth = uint32_t( depth );
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void set_instrument_sink( instrument_sink *sink ) noexcept
+{
+	detail::instrument_sink_ptr.store( sink, std::memory_order_release );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline instrument_sink *get_instrument_sink() noexcept
+{
+	return detail::instrument_sink_ptr.load( std::memory_order_acquire );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline uint64_t allocation_counts::total() const noexcept
+{
+	uint64_t result = 0;
+	for ( auto c : count )
+		result += c;
+
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline uint64_t allocation_counts::total_bytes() const noexcept
+{
+	uint64_t result = 0;
+	for ( auto b : bytes )
+		result += b;
+
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline allocation_tracker::allocation_tracker() noexcept
+	: _parent( detail::allocation_current )
+{
+	detail::allocation_current = &_counts;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline allocation_tracker::~allocation_tracker()
+{
+	detail::allocation_current = _parent;
+
+	if ( _parent )
+	{
+		for ( size_t i = 0; i < allocation_counts::num_sites; ++i )
+		{
+			_parent->count[i] += _counts.count[i];
+			_parent->bytes[i] += _counts.bytes[i];
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void histogram::add( uint64_t sample ) noexcept
+{
+	_buckets[std::bit_width( sample )].fetch_add( 1, std::memory_order_relaxed );
+	_count.fetch_add( 1, std::memory_order_relaxed );
+	_sum.fetch_add( sample, std::memory_order_relaxed );
+
+	for ( auto prev = _max.load( std::memory_order_relaxed ); sample > prev; )
+		if ( _max.compare_exchange_weak( prev, sample, std::memory_order_relaxed ) )
+			break;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline uint64_t histogram::quantile( double q ) const noexcept
+{
+	const auto total = count();
+	if ( !total )
+		return 0;
+
+	const auto rank = uint64_t( q * double( total - 1 ) ) + 1;
+
+	uint64_t seen = 0;
+	for ( size_t i = 0; i < num_buckets; ++i )
+		if ( ( seen += bucket( i ) ) >= rank )
+			return i == 0 ? 0 : ( i >= 64 ? max() : std::min( max(), ( uint64_t( 1 ) << i ) - 1 ) );
+
+	return max();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void histogram_sink::record( const instrument_stats &stats )
+{
+	auto &h = stats.operation == instrument_stats::parse ? _parse : _write;
+
+	h.total_ns.add( stats.total_ns );
+	h.tokenize_ns.add( stats.tokenize_ns );
+	h.build_ns.add( stats.build_ns );
+	h.relink_ns.add( stats.relink_ns );
+	h.write_ns.add( stats.write_ns );
+	h.bytes.add( stats.bytes );
+	h.values.add( stats.values );
+	h.max_depth.add( stats.max_depth );
+	h.allocations.add( stats.allocations );
+}
+
+} // namespace json5
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define JSON5_INSTRUMENT_CONCAT_( a, b ) a##b
+#define JSON5_INSTRUMENT_CONCAT( a, b ) JSON5_INSTRUMENT_CONCAT_( a, b )
+
+#if defined( JSON5_INSTRUMENTATION )
+	// Instruments the enclosing call as 'parse' or 'write' operation
+	#define JSON5_INSTRUMENT_SCOPE( operation ) \
+		json5::detail::instrument_scope json5InstrumentScope( json5::instrument_stats::operation )
+
+	// Accounts time of the enclosing scope to 'tokenize' or 'relink' phase
+	#define JSON5_INSTRUMENT_PHASE( phase ) \
+		json5::detail::instrument_phase json5InstrumentPhase( &json5::instrument_stats::phase##_ns )
+
+	// Counts bytes written into 'stream' by the enclosing scope
+	#define JSON5_INSTRUMENT_OUTPUT( stream ) \
+		json5::detail::instrument_output json5InstrumentOutput( stream )
+
+	// Shares stats of the enclosing call with workers of a parallel operation
+	#define JSON5_INSTRUMENT_FORK() \
+		json5::detail::instrument_fork json5InstrumentFork
+
+	// Accounts work of the enclosing scope on a worker thread to the forked call, output nested 'baseDepth' levels deep
+	#define JSON5_INSTRUMENT_WORKER( baseDepth ) \
+		json5::detail::instrument_worker json5InstrumentWorker( json5InstrumentFork, baseDepth )
+
+	#define JSON5_INSTRUMENT_COUNT( field, count ) json5::detail::instrument_count( &json5::instrument_stats::field, count )
+	#define JSON5_INSTRUMENT_DEPTH( depth ) json5::detail::instrument_depth( depth )
+#else
+	#define JSON5_INSTRUMENT_SCOPE( operation )
+	#define JSON5_INSTRUMENT_FORK()
+	#define JSON5_INSTRUMENT_WORKER( baseDepth )
+	#define JSON5_INSTRUMENT_PHASE( phase )
+	#define JSON5_INSTRUMENT_OUTPUT( stream )
+	#define JSON5_INSTRUMENT_COUNT( field, count )
+	#define JSON5_INSTRUMENT_DEPTH( depth )
+#endif
+
+#if defined( JSON5_INSTRUMENTATION ) || defined( JSON5_ALLOCATION_TRACKING )
+	// Counts a reallocation at 'site', if capacity of 'container' changed in the enclosing scope
+	#define JSON5_INSTRUMENT_GROWTH( site, container ) \
+		json5::detail::instrument_growth JSON5_INSTRUMENT_CONCAT( json5InstrumentGrowth, __LINE__ )( json5::allocation_site::site, container )
+
+	// Counts 'count' allocations of 'bytes' in total at 'site'
+	#define JSON5_INSTRUMENT_ALLOCATION( site, count, bytes ) \
+		json5::detail::track_allocation( json5::allocation_site::site, count, bytes )
+#else
+	#define JSON5_INSTRUMENT_GROWTH( site, container )
+	#define JSON5_INSTRUMENT_ALLOCATION( site, count, bytes )
+#endif
@@ -0,0 +1,493 @@
+#pragma once
+
+#include "json5_builder.hpp"
+#include "json5_bytes.hpp"
+
+/*
+	Direct conversion between json5::document and MessagePack, without going through text.
+
+	Numbers are written in the smallest integer format when they have no fractional part, otherwise
+	as float64. When reading, bin data becomes arrays of numbers, map keys must be strings and extension
+	types are not supported.
+*/
+
+namespace json5 {
+
+//
+void to_msgpack( std::vector<uint8_t> &out, const json5::value &in );
+
+//
+std::vector<uint8_t> to_msgpack( const json5::value &in );
+
+// Writes to stream in chunks while encoding
+void to_msgpack( std::ostream &os, const json5::value &in );
+
+//
+error from_msgpack( const void *data, size_t size, document &doc );
+
+//
+error from_msgpack( const std::vector<uint8_t> &data, document &doc );
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+//---------------------------------------------------------------------------------------------------------------------
+class msgpack_writer final
+{
+public:
+	msgpack_writer( byte_sink &out ) : _out( out ) { }
+
+	void write( const json5::value &v );
+
+private:
+	void number( double d );
+	void string( std::string_view str );
+	void head( uint8_t fix, uint8_t fixLimit, uint8_t code16, uint8_t code32, size_t size );
+
+	byte_sink &_out;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+class msgpack_parser final : builder
+{
+public:
+	msgpack_parser( document &doc, const void *data, size_t size ) : builder( doc ), _in( data, size ) { }
+
+	// Parse document, root must be a map or an array
+	error parse();
+
+private:
+	template <typename T> error parse_length( uint32_t &length );
+	error parse_value( value &result );
+	error parse_string( uint32_t length, detail::string_offset &offset );
+	error parse_key( detail::string_offset &offset );
+	error parse_bin( uint32_t length );
+	error parse_array( uint32_t length );
+	error parse_map( uint32_t length );
+
+	template <typename T>
+	error parse_number( value &result )
+	{
+		T v = 0;
+		if ( auto err = _in.get_be( v ) )
+			return err;
+
+		result = value( double( v ) );
+		return { error::none };
+	}
+
+	byte_source _in;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void msgpack_writer::write( const json5::value &v )
+{
+	if ( v.is_null() )
+		_out.put( 0xc0 );
+	else if ( v.is_boolean() )
+		_out.put( v.get_bool() ? 0xc3 : 0xc2 );
+	else if ( v.is_number() )
+		number( v.get<double>() );
+	else if ( v.is_string() )
+		string( v.get_c_str() );
+	else if ( v.is_array() )
+	{
+		auto arr = json5::array_view( v );
+		head( 0x90, 16, 0xdc, 0xdd, arr.size() );
+
+		bool allNumbers = true;
+		for ( const auto &i : arr )
+			allNumbers &= i.is_number();
+
+		// Numbers only: reserve for the largest encoding once and skip per-item type dispatch
+		if ( allNumbers )
+		{
+			_out.reserve( arr.size() * ( 1 + sizeof( double ) ) );
+			for ( const auto &i : arr )
+				number( i.get<double>() );
+		}
+		else
+		{
+			for ( const auto &i : arr )
+				write( i );
+		}
+	}
+	else if ( v.is_object() )
+	{
+		auto obj = json5::object_view( v );
+		head( 0x80, 16, 0xde, 0xdf, obj.size() );
+
+		for ( auto kvp : obj )
+		{
+			string( kvp.first );
+			write( kvp.second );
+		}
+	}
+
+	_out.flush_if_needed();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void msgpack_writer::number( double d )
+{
+	if ( !is_integral_number( d ) )
+	{
+		_out.put( 0xcb );
+		_out.put_be( d );
+	}
+	else if ( d >= 0.0 )
+	{
+		auto u = uint64_t( d );
+
+		if ( u < 128 )
+			_out.put( uint8_t( u ) );
+		else if ( u <= 0xff )
+		{
+			_out.put( 0xcc );
+			_out.put( uint8_t( u ) );
+		}
+		else if ( u <= 0xffff )
+		{
+			_out.put( 0xcd );
+			_out.put_be( uint16_t( u ) );
+		}
+		else if ( u <= 0xffffffff )
+		{
+			_out.put( 0xce );
+			_out.put_be( uint32_t( u ) );
+		}
+		else
+		{
+			_out.put( 0xcf );
+			_out.put_be( u );
+		}
+	}
+	else
+	{
+		auto i = int64_t( d );
+
+		if ( i >= -32 )
+			_out.put( uint8_t( i ) );
+		else if ( i >= INT8_MIN )
+		{
+			_out.put( 0xd0 );
+			_out.put( uint8_t( i ) );
+		}
+		else if ( i >= INT16_MIN )
+		{
+			_out.put( 0xd1 );
+			_out.put_be( uint16_t( i ) );
+		}
+		else if ( i >= INT32_MIN )
+		{
+			_out.put( 0xd2 );
+			_out.put_be( uint32_t( i ) );
+		}
+		else
+		{
+			_out.put( 0xd3 );
+			_out.put_be( uint64_t( i ) );
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void msgpack_writer::string( std::string_view str )
+{
+	if ( str.size() < 32 )
+		_out.put( uint8_t( 0xa0 | str.size() ) );
+	else if ( str.size() <= 0xff )
+	{
+		_out.put( 0xd9 );
+		_out.put( uint8_t( str.size() ) );
+	}
+	else
+		head( 0, 0, 0xda, 0xdb, str.size() );
+
+	_out.put( str.data(), str.size() );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Size prefix of arrays, maps and long strings
+inline void msgpack_writer::head( uint8_t fix, uint8_t fixLimit, uint8_t code16, uint8_t code32, size_t size )
+{
+	if ( size < fixLimit )
+		_out.put( uint8_t( fix | size ) );
+	else if ( size <= 0xffff )
+	{
+		_out.put( code16 );
+		_out.put_be( uint16_t( size ) );
+	}
+	else
+	{
+		_out.put( code32 );
+		_out.put_be( uint32_t( size ) );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error msgpack_parser::parse()
+{
+	reset();
+
+	if ( auto err = parse_value( _doc ) )
+		return err;
+
+	if ( !_doc.is_array() && !_doc.is_object() )
+		return _in.make_error( error::invalid_root );
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error msgpack_parser::parse_length( uint32_t &length )
+{
+	T v = 0;
+	auto err = _in.get_be( v );
+	length = v;
+	return err;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error msgpack_parser::parse_value( value &result )
+{
+	uint8_t code = 0;
+	if ( auto err = _in.get( code ) )
+		return err;
+
+	uint32_t length = 0;
+	error err;
+
+	if ( code < 0x80 || code >= 0xe0 )
+	{
+		result = value( double( int8_t( code ) ) );
+		return { error::none };
+	}
+	else if ( code < 0x90 )
+		length = code & 0x0f, code = 0xdf;
+	else if ( code < 0xa0 )
+		length = code & 0x0f, code = 0xdd;
+	else if ( code < 0xc0 )
+		length = code & 0x1f, code = 0xdb;
+	else
+	{
+		switch ( code )
+		{
+			case 0xc4: case 0xd9: err = parse_length<uint8_t>( length ); break;
+			case 0xc5: case 0xda: case 0xdc: case 0xde: err = parse_length<uint16_t>( length ); break;
+			case 0xc6: case 0xdb: case 0xdd: case 0xdf: err = parse_length<uint32_t>( length ); break;
+		}
+
+		if ( err )
+			return err;
+	}
+
+	switch ( code )
+	{
+		case 0xc0: result = value(); break;
+		case 0xc2: result = value( false ); break;
+		case 0xc3: result = value( true ); break;
+
+		case 0xca:
+		{
+			float f = 0.0f;
+			if ( auto err = _in.get_be( f ) )
+				return err;
+
+			result = value( detail::decoded_number( f ) );
+		}
+		break;
+
+		case 0xcb:
+		{
+			double d = 0.0;
+			if ( auto err = _in.get_be( d ) )
+				return err;
+
+			result = value( detail::decoded_number( d ) );
+		}
+		break;
+
+		case 0xcc: return parse_number<uint8_t>( result );
+		case 0xcd: return parse_number<uint16_t>( result );
+		case 0xce: return parse_number<uint32_t>( result );
+		case 0xcf: return parse_number<uint64_t>( result );
+		case 0xd0: return parse_number<int8_t>( result );
+		case 0xd1: return parse_number<int16_t>( result );
+		case 0xd2: return parse_number<int32_t>( result );
+		case 0xd3: return parse_number<int64_t>( result );
+
+		case 0xd9: case 0xda: case 0xdb:
+		{
+			detail::string_offset offset = 0;
+			if ( auto err = parse_string( length, offset ) )
+				return err;
+
+			result = new_string( offset );
+		}
+		break;
+
+		case 0xc4: case 0xc5: case 0xc6:
+			push_array();
+			{
+				if ( auto err = parse_bin( length ) )
+					return err;
+			}
+			result = pop();
+			break;
+
+		case 0xdc: case 0xdd:
+			push_array();
+			{
+				if ( auto err = parse_array( length ) )
+					return err;
+			}
+			result = pop();
+			break;
+
+		case 0xde: case 0xdf:
+			push_object();
+			{
+				if ( auto err = parse_map( length ) )
+					return err;
+			}
+			result = pop();
+			break;
+
+		default:
+			return _in.make_error( error::syntax_error );
+	}
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error msgpack_parser::parse_string( uint32_t length, detail::string_offset &offset )
+{
+	const uint8_t *data = nullptr;
+	if ( auto err = _in.get( length, data ) )
+		return err;
+
+	offset = string_buffer_add( std::string_view( reinterpret_cast<const char *>( data ), length ) );
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error msgpack_parser::parse_key( detail::string_offset &offset )
+{
+	uint8_t code = 0;
+	if ( auto err = _in.get( code ) )
+		return err;
+
+	uint32_t length = 0;
+	error err;
+
+	if ( code >= 0xa0 && code < 0xc0 )
+		length = code & 0x1f;
+	else if ( code == 0xd9 )
+		err = parse_length<uint8_t>( length );
+	else if ( code == 0xda )
+		err = parse_length<uint16_t>( length );
+	else if ( code == 0xdb )
+		err = parse_length<uint32_t>( length );
+	else
+		return _in.make_error( error::string_expected );
+
+	if ( err )
+		return err;
+
+	return parse_string( length, offset );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error msgpack_parser::parse_bin( uint32_t length )
+{
+	const uint8_t *data = nullptr;
+	if ( auto err = _in.get( length, data ) )
+		return err;
+
+	for ( uint32_t i = 0; i < length; ++i )
+		( *this ) += value( double( data[i] ) );
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error msgpack_parser::parse_array( uint32_t length )
+{
+	for ( uint32_t i = 0; i < length; ++i )
+	{
+		value newValue;
+		if ( auto err = parse_value( newValue ) )
+			return err;
+
+		( *this ) += newValue;
+	}
+
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error msgpack_parser::parse_map( uint32_t length )
+{
+	for ( uint32_t i = 0; i < length; ++i )
+	{
+		detail::string_offset keyOffset = 0;
+		if ( auto err = parse_key( keyOffset ) )
+			return err;
+
+		value newValue;
+		if ( auto err = parse_value( newValue ) )
+			return err;
+
+		( *this )[keyOffset] = newValue;
+	}
+
+	return { error::none };
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void to_msgpack( std::vector<uint8_t> &out, const json5::value &in )
+{
+	out.clear();
+	detail::byte_sink sink( out );
+	detail::msgpack_writer( sink ).write( in );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<uint8_t> to_msgpack( const json5::value &in )
+{
+	std::vector<uint8_t> result;
+	to_msgpack( result, in );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void to_msgpack( std::ostream &os, const json5::value &in )
+{
+	detail::byte_sink sink( os );
+	detail::msgpack_writer( sink ).write( in );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error from_msgpack( const void *data, size_t size, document &doc )
+{
+	detail::msgpack_parser p( doc, data, size );
+	return p.parse();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline error from_msgpack( const std::vector<uint8_t> &data, document &doc )
+{
+	return from_msgpack( data.data(), data.size(), doc );
+}
+
+} // namespace json5
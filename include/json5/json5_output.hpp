@@ -2,8 +2,12 @@
 
 #include "json5.hpp"
 
+#include <cassert>
+#include <cctype>
+#include <cmath>
 #include <iomanip>
 #include <fstream>
+#include <limits>
 #include <sstream>
 
 namespace json5 {
@@ -22,71 +26,236 @@ bool to_file( const std::string &fileName, const document &doc, const writer_par
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/*
+
+json5::stream_writer
+
+Writes JSON5 text directly into a stream without building a json5::document first. Commas, indentation
+and 'writer_params' are handled incrementally, memory usage only depends on the nesting depth:
+
+	json5::stream_writer w( std::cout );
+	w.begin_object();
+	w.key( "x" ).value( 123 );
+	w.key( "arr" ).begin_array().value( "a" ).value( true ).null().end_array();
+	w.end_object();
+
+Unbalanced calls ('key' outside of an object, 'end_object' or 'end_array' not matching the innermost open
+container) and misplaced ones (a value in an object without a key, a key following another key) assert in
+debug builds. Otherwise they set 'failbit' on the stream, which stops further output.
+*/
+class stream_writer final
+{
+public:
+	stream_writer( std::ostream &os, const writer_params &wp = writer_params() ) : _os( os ), _params( wp ) { }
+
+	// Writer for a value which will be placed at 'baseDepth' of an enclosing output (see 'raw_value').
+	// Nested lines are indented accordingly and no end of line is written after the value.
+	stream_writer( std::ostream &os, const writer_params &wp, size_t baseDepth ) : _os( os ), _params( wp ), _baseDepth( baseDepth ) { }
+
+	const writer_params &params() const noexcept { return _params; }
+
+	// Current nesting depth (number of open objects and arrays)
+	size_t depth() const noexcept { return _depth; }
+
+	stream_writer &begin_object();
+	stream_writer &end_object();
+	stream_writer &begin_array();
+	stream_writer &end_array();
+
+	// Write property key, must be followed by a value (or begin_object/begin_array)
+	stream_writer &key( std::string_view key );
+
+	stream_writer &null();
+	stream_writer &value( std::nullptr_t ) { return null(); }
+	stream_writer &value( bool val );
+	stream_writer &value( const char *str ) { return value( std::string_view( str ) ); }
+	stream_writer &value( std::string_view str );
+
+	// Write JSON value (including nested objects and arrays)
+	stream_writer &value( const json5::value &v );
+
+	// Write already formatted value text as is, e.g. cached output of a writer created with matching 'baseDepth'.
+	// Instrumentation counts values of 'text' where it was formatted, not here.
+	stream_writer &raw_value( std::string_view text );
+
+	// Write number (will be converted to double)
+	template <typename T>
+	std::enable_if_t<std::is_arithmetic_v<T>, stream_writer &> value( T val ) { return number( double( val ) ); }
+
+private:
+	struct frame
+	{
+		bool object = false;
+		size_t count = 0;
+	};
+
+	stream_writer &number( double d );
+	stream_writer &begin( bool object, char ch );
+	stream_writer &end( char ch );
+
+	void begin_value();
+	void end_value();
+	void next_item();
+	void separate_value();
+	void indent( size_t depth );
+
+	// Checks that a call is allowed at the current depth, fails the stream otherwise
+	bool expect( bool valid );
+
+	frame &top() noexcept { return ( _depth <= inline_depth ) ? _frames[_depth - 1] : _overflow[_depth - inline_depth - 1]; }
+
+	std::ostream &_os;
+	writer_params _params;
+
+	// Nesting stack, deep documents spill into '_overflow'
+	static constexpr size_t inline_depth = 32;
+	frame _frames[inline_depth];
+	std::vector<frame> _overflow;
+	size_t _depth = 0;
+	size_t _baseDepth = 0;
+
+	// 'key' was written, its value was not yet
+	bool _keyPending = false;
+};
+
+namespace detail {
+
+/*
+
+json5::detail::string_ostream
+
+Output stream appending directly to a std::string. Unlike std::ostringstream it does not copy the result
+and reuses capacity of the target string, so repeated 'to_string' calls into the same string do not allocate.
+Text is complete after 'flush' or destruction.
+
+*/
+class string_streambuf final : public std::streambuf
+{
+public:
+	string_streambuf( std::string &str ) : _str( str ) { setp( _buffer, _buffer + sizeof( _buffer ) ); }
+	~string_streambuf() override { sync(); }
+
+protected:
+	int_type overflow( int_type ch ) override
+	{
+		sync();
+
+		if ( traits_type::eq_int_type( ch, traits_type::eof() ) )
+			return traits_type::not_eof( ch );
+
+		*pptr() = traits_type::to_char_type( ch );
+		pbump( 1 );
+		return ch;
+	}
+
+	std::streamsize xsputn( const char *s, std::streamsize count ) override
+	{
+		if ( count > epptr() - pptr() )
+		{
+			sync();
+
+			if ( count >= std::streamsize( sizeof( _buffer ) ) )
+			{
+				JSON5_INSTRUMENT_GROWTH( output, _str );
+				_str.append( s, size_t( count ) );
+				return count;
+			}
+		}
+
+		memcpy( pptr(), s, size_t( count ) );
+		pbump( int( count ) );
+		return count;
+	}
+
+	int sync() override
+	{
+		JSON5_INSTRUMENT_GROWTH( output, _str );
+		_str.append( pbase(), size_t( pptr() - pbase() ) );
+		setp( _buffer, _buffer + sizeof( _buffer ) );
+		return 0;
+	}
+
+	// Only reports the current position (for 'tellp')
+	pos_type seekoff( off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which ) override
+	{
+		if ( off != 0 || dir != std::ios_base::cur || !( which & std::ios_base::out ) )
+			return pos_type( off_type( -1 ) );
+
+		return pos_type( off_type( _str.size() + size_t( pptr() - pbase() ) ) );
+	}
+
+private:
+	std::string &_str;
+	char _buffer[512];
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+class string_ostream final : public std::ostream
+{
+public:
+	string_ostream( std::string &str ) : std::ostream( nullptr ), _buf( str ) { rdbuf( &_buf ); }
+
+private:
+	string_streambuf _buf;
+};
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 //---------------------------------------------------------------------------------------------------------------------
-inline void to_stream( std::ostream &os, const char *str, char quotes, bool escapeUnicode )
+inline void to_stream( std::ostream &os, std::string_view str, char quotes, bool escapeUnicode )
 {
 	if ( quotes )
 		os << quotes;
 
-	while ( *str )
+	for ( auto *s = str.data(), *end = s + str.size(); s < end; )
 	{
 		bool advance = true;
 
-		if ( str[0] == '\n' )
+		if ( s[0] == '\n' )
 			os << "\\n";
-		else if ( str[0] == '\r' )
+		else if ( s[0] == '\r' )
 			os << "\\r";
-		else if ( str[0] == '\t' )
+		else if ( s[0] == '\t' )
 			os << "\\t";
-		else if ( str[0] == '"' && quotes == '"' )
+		else if ( s[0] == '"' && quotes == '"' )
 			os << "\\\"";
-		else if ( str[0] == '\'' && quotes == '\'' )
+		else if ( s[0] == '\'' && quotes == '\'' )
 			os << "\\'";
-		else if ( str[0] == '\\' )
+		else if ( s[0] == '\\' )
 			os << "\\\\";
-		else if ( uint8_t( str[0] ) >= 128 && escapeUnicode )
+		else if ( uint8_t( s[0] ) >= 128 && escapeUnicode )
 		{
-			uint32_t ch = 0;
-
-			if ( ( *str & 0b1110'0000u ) == 0b1100'0000u )
-			{
-				ch |= ( ( *str++ ) & 0b0001'1111u ) << 6;
-				ch |= ( ( *str++ ) & 0b0011'1111u );
-			}
-			else if ( ( *str & 0b1111'0000u ) == 0b1110'0000u )
-			{
-				ch |= ( ( *str++ ) & 0b0000'1111u ) << 12;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 6;
-				ch |= ( ( *str++ ) & 0b0011'1111u );
-			}
-			else if ( ( *str & 0b1111'1000u ) == 0b1111'0000u )
-			{
-				ch |= ( ( *str++ ) & 0b0000'0111u ) << 18;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 12;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 6;
-				ch |= ( ( *str++ ) & 0b0011'1111u );
-			}
-			else if ( ( *str & 0b1111'1100u ) == 0b1111'1000u )
-			{
-				ch |= ( ( *str++ ) & 0b0000'0011u ) << 24;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 18;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 12;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 6;
-				ch |= ( ( *str++ ) & 0b0011'1111u );
-			}
-			else if ( ( *str & 0b1111'1110u ) == 0b1111'1100u )
+			// Sequence length and payload bits of the lead byte
+			const uint8_t lead = uint8_t( *s );
+			const size_t len = ( lead & 0b1110'0000u ) == 0b1100'0000u ? 2
+			                 : ( lead & 0b1111'0000u ) == 0b1110'0000u ? 3
+			                 : ( lead & 0b1111'1000u ) == 0b1111'0000u ? 4
+			                 : ( lead & 0b1111'1100u ) == 0b1111'1000u ? 5
+			                 : ( lead & 0b1111'1110u ) == 0b1111'1100u ? 6
+			                 : 0;
+
+			uint32_t ch = 0xFFFD; // Replacement character
+
+			// Invalid lead bytes and sequences cut off by the end of 'str' are replaced, one byte at a time
+			if ( len == 0 || size_t( end - s ) < len )
+				++s;
+			else
 			{
-				ch |= ( ( *str++ ) & 0b0000'0001u ) << 30;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 24;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 18;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 12;
-				ch |= ( ( *str++ ) & 0b0011'1111u ) << 6;
-				ch |= ( ( *str++ ) & 0b0011'1111u );
+				ch = lead & ( 0b0111'1111u >> len );
+				for ( size_t i = 1; i < len; ++i )
+					ch = ( ch << 6 ) | ( uint8_t( s[i] ) & 0b0011'1111u );
+
+				s += len;
 			}
 
 			if ( ch <= std::numeric_limits<uint16_t>::max() )
 			{
-				os << "\\u" << std::hex << std::setfill( '0' ) << std::setw( 4 ) << ch;
+				// Don't use std::hex, it would stick to the stream and garble numbers written later
+				static constexpr const char *hexChars = "0123456789abcdef";
+				const char code[6] = { '\\', 'u', hexChars[( ch >> 12 ) & 15], hexChars[( ch >> 8 ) & 15], hexChars[( ch >> 4 ) & 15], hexChars[ch & 15] };
+				os.write( code, 6 );
 			}
 			else
 				os << "?"; // JSON can't encode Unicode chars > 65535 (emojis)
@@ -94,10 +263,10 @@ inline void to_stream( std::ostream &os, const char *str, char quotes, bool esca
 			advance = false;
 		}
 		else
-			os << *str;
+			os << *s;
 
 		if ( advance )
-			++str;
+			++s;
 	}
 
 	if ( quotes )
@@ -105,95 +274,245 @@ inline void to_stream( std::ostream &os, const char *str, char quotes, bool esca
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-inline void to_stream( std::ostream &os, const value &v, const writer_params &wp, int depth )
+inline stream_writer &stream_writer::begin_object() { return begin( true, '{' ); }
+inline stream_writer &stream_writer::end_object() { return end( '}' ); }
+inline stream_writer &stream_writer::begin_array() { return begin( false, '[' ); }
+inline stream_writer &stream_writer::end_array() { return end( ']' ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::key( std::string_view key )
 {
-	const char *kvSeparator = ": ";
-	const char *eol = wp.eol;
+	if ( !expect( _depth > 0 && top().object && !_keyPending ) )
+		return *this;
 
-	if ( wp.compact )
-	{
-		depth = -1;
-		kvSeparator = ":";
-		eol = "";
-	}
+	next_item();
+	_keyPending = true;
+
+	bool identifier = !key.empty() && ( isalpha( uint8_t( key[0] ) ) || key[0] == '_' );
+	for ( size_t i = 1; identifier && i < key.size(); ++i )
+		identifier = isalnum( uint8_t( key[i] ) ) || key[i] == '_';
+
+	if ( _params.json_compatible || !identifier )
+		to_stream( _os, key, '"', _params.escape_unicode );
+	else
+		_os << key;
+
+	_os << ( _params.compact ? ":" : ": " );
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::null()
+{
+	begin_value();
+	_os << "null";
+	end_value();
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::value( bool val )
+{
+	begin_value();
+	_os << ( val ? "true" : "false" );
+	end_value();
+	return *this;
+}
 
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::value( std::string_view str )
+{
+	begin_value();
+	to_stream( _os, str, '"', _params.escape_unicode );
+	end_value();
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::value( const json5::value &v )
+{
 	if ( v.is_null() )
-		os << "null";
+		null();
 	else if ( v.is_boolean() )
-		os << ( v.get_bool() ? "true" : "false" );
+		value( v.get_bool() );
 	else if ( v.is_number() )
-	{
-		if ( double _, d = v.get<double>(); modf( d, &_ ) == 0.0 )
-			os << v.get<int64_t>();
-		else
-			os << d;
-	}
+		number( v.get<double>() );
 	else if ( v.is_string() )
-	{
-		to_stream( os, v.get_c_str(), '"', wp.escape_unicode );
-	}
+		value( v.get_c_str() );
 	else if ( v.is_array() )
 	{
-		if ( auto av = json5::array_view( v ); !av.empty() )
-		{
-			os << "[" << eol;
-			for ( size_t i = 0, S = av.size(); i < S; ++i )
-			{
-				for ( int i = 0; i <= depth; ++i ) os << wp.indentation;
-				to_stream( os, av[i], wp, depth + 1 );
-				if ( i < S - 1 ) os << ",";
-				os << eol;
-			}
+		begin_array();
 
-			for ( int i = 0; i < depth; ++i ) os << wp.indentation;
-			os << "]";
-		}
-		else
-			os << "[]";
+		for ( auto item : array_view( v ) )
+			value( item );
+
+		end_array();
 	}
 	else if ( v.is_object() )
 	{
-		if ( auto ov = json5::object_view( v ); !ov.empty() )
-		{
-			os << "{" << eol;
-			size_t count = ov.size();
-			for ( auto kvp : ov )
-			{
-				for ( int i = 0; i <= depth; ++i ) os << wp.indentation;
+		begin_object();
 
-				if ( wp.json_compatible )
-					os << "\"" << kvp.first << "\"" << kvSeparator;
-				else
-					os << kvp.first << kvSeparator;
+		for ( auto kvp : object_view( v ) )
+			key( kvp.first ).value( kvp.second );
 
-				to_stream( os, kvp.second, wp, depth + 1 );
-				if ( --count ) os << ",";
-				os << eol;
-			}
+		end_object();
+	}
 
-			for ( int i = 0; i < depth; ++i ) os << wp.indentation;
-			os << "}";
-		}
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::raw_value( std::string_view text )
+{
+	// Like 'begin_value', but not instrumented, values in 'text' were counted by the writer which formatted it
+	separate_value();
+
+	_os << text;
+	end_value();
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::number( double d )
+{
+	begin_value();
+
+	if ( std::isnan( d ) || std::isinf( d ) )
+	{
+		// JSON has no literals for these
+		if ( _params.json_compatible )
+			_os << "null";
 		else
-			os << "{}";
+			_os << ( std::isnan( d ) ? "NaN" : ( d < 0.0 ? "-Infinity" : "Infinity" ) );
+	}
+	else if ( double _; modf( d, &_ ) == 0.0 && d >= -9223372036854775808.0 && d < 9223372036854775808.0 )
+		_os << int64_t( d ); // Integral and in range of int64
+	else
+		_os << d;
+
+	end_value();
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::begin( bool object, char ch )
+{
+	begin_value();
+	_os << ch;
+
+	if ( ++_depth > inline_depth )
+	{
+		JSON5_INSTRUMENT_GROWTH( output, _overflow );
+		_overflow.emplace_back();
+	}
+
+	JSON5_INSTRUMENT_DEPTH( _depth );
+
+	top() = frame{ object, 0 };
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline stream_writer &stream_writer::end( char ch )
+{
+	if ( !expect( _depth > 0 && top().object == ( ch == '}' ) && !_keyPending ) )
+		return *this;
+
+	bool empty = top().count == 0;
+
+	if ( _depth-- > inline_depth )
+		_overflow.pop_back();
+
+	if ( !empty )
+	{
+		if ( !_params.compact )
+			_os << _params.eol;
+
+		indent( _baseDepth + _depth );
 	}
 
-	if ( !depth )
-		os << eol;
+	_os << ch;
+	end_value();
+	return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void stream_writer::begin_value()
+{
+	JSON5_INSTRUMENT_COUNT( values, 1 );
+	separate_value();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void stream_writer::separate_value()
+{
+	if ( _depth == 0 )
+		return;
+
+	// Array items are separated here, object items are separated by 'key'
+	if ( !top().object )
+		next_item();
+	else if ( expect( _keyPending ) )
+		_keyPending = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void stream_writer::end_value()
+{
+	if ( _depth == 0 && _baseDepth == 0 && !_params.compact )
+		_os << _params.eol;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline void stream_writer::next_item()
+{
+	if ( top().count++ )
+		_os << ",";
+
+	if ( !_params.compact )
+		_os << _params.eol;
+
+	indent( _baseDepth + _depth );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void stream_writer::indent( size_t depth )
+{
+	if ( !_params.compact )
+		for ( size_t i = 0; i < depth; ++i )
+			_os << _params.indentation;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool stream_writer::expect( bool valid )
+{
+	assert( valid && "json5::stream_writer: unbalanced or misplaced key, value, end_object or end_array" );
+
+	if ( !valid )
+		_os.setstate( std::ios::failbit );
+
+	return valid;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 //---------------------------------------------------------------------------------------------------------------------
 inline void to_stream( std::ostream &os, const document &doc, const writer_params &wp )
 {
-	to_stream( os, doc, wp, 0 );
+	JSON5_INSTRUMENT_SCOPE( write );
+	JSON5_INSTRUMENT_OUTPUT( os );
+
+	stream_writer( os, wp ).value( doc );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 inline void to_string( std::string &str, const document &doc, const writer_params &wp )
 {
-	std::ostringstream os;
+	str.clear();
+
+	detail::string_ostream os( str );
 	to_stream( os, doc, wp );
-	str = os.str();
+	os.flush();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
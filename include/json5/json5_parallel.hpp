@@ -0,0 +1,375 @@
+#pragma once
+
+#include "json5_filter.hpp"
+#include "json5_reflect.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace json5 {
+
+//---------------------------------------------------------------------------------------------------------------------
+struct parallel_params
+{
+	// Number of threads (the calling thread included), 0 = std::thread::hardware_concurrency()
+	unsigned num_threads = 0;
+
+	// Number of items processed by one thread at a time
+	size_t chunk_size = 1024;
+};
+
+// Reads root array of 'doc' into 'out' on multiple threads. Returns the error of the lowest failing index,
+// and stores that index in 'errorIndex' (when not null).
+template <typename T, typename A>
+error from_document_parallel( const document &doc, std::vector<T, A> &out, const parallel_params &pp = parallel_params(),
+                              size_t *errorIndex = nullptr );
+
+// Same matches as 'json5::filter', in document order. Items of arrays with more than 'chunk_size' items are
+// matched on multiple threads, in chunks.
+std::vector<json5::value> filter_parallel( const json5::value &in, const compiled_filter &pattern, const parallel_params &pp = parallel_params() );
+
+//
+std::vector<json5::value> filter_parallel( const json5::value &in, std::string_view pattern, const parallel_params &pp = parallel_params() );
+
+// Matches of each pattern in 'patterns', indexed by pattern
+std::vector<std::vector<json5::value>> filter_parallel( const json5::value &in, const filter_set &patterns, const parallel_params &pp = parallel_params() );
+
+// Same text as 'json5::to_string'. Items of a root array with more than 'chunk_size' items are formatted
+// on multiple threads, each chunk into its own buffer, and the buffers are joined in order.
+void to_string_parallel( std::string &str, const document &doc, const writer_params &wp = writer_params(), const parallel_params &pp = parallel_params() );
+
+//
+std::string to_string_parallel( const document &doc, const writer_params &wp = writer_params(), const parallel_params &pp = parallel_params() );
+
+// Same text as 'json5::to_string' of a reflected array, items are formatted on multiple threads in chunks
+template <typename T, typename A>
+void to_string_parallel( std::string &str, const std::vector<T, A> &in, const writer_params &wp = writer_params(), const parallel_params &pp = parallel_params() );
+
+// Converts each of 'docs' to string on multiple threads, 'chunk_size' documents at a time
+std::vector<std::string> to_string_parallel( std::span<const document> docs, const writer_params &wp = writer_params(), const parallel_params &pp = parallel_params{ 0, 16 } );
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+//---------------------------------------------------------------------------------------------------------------------
+inline unsigned num_threads( const parallel_params &pp ) noexcept
+{
+	return pp.num_threads ? pp.num_threads : std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Calls 'func( begin, end )' for chunks of [0, count). Chunks are handed out through an atomic counter
+// to up to 'num_threads' threads, the calling thread included. 'func( thread, begin, end )' also receives
+// index of the calling thread (below 'num_threads'), e.g. to pick per-thread scratch state.
+template <typename Func>
+inline void parallel_for( size_t count, const parallel_params &pp, const Func &func )
+{
+	const size_t chunkSize = std::max<size_t>( pp.chunk_size, 1 );
+	const size_t numChunks = ( count + chunkSize - 1 ) / chunkSize;
+	const size_t numThreads = std::min<size_t>( num_threads( pp ), numChunks );
+
+	auto call = [&func]( unsigned thread, size_t begin, size_t end )
+	{
+		if constexpr ( std::is_invocable_v<const Func &, unsigned, size_t, size_t> )
+			func( thread, begin, end );
+		else
+			func( begin, end );
+	};
+
+	if ( numThreads <= 1 )
+	{
+		if ( count )
+			call( 0u, size_t( 0 ), count );
+
+		return;
+	}
+
+	std::atomic<size_t> nextChunk = 0;
+	auto worker = [&]( unsigned thread )
+	{
+		for ( size_t chunk; ( chunk = nextChunk.fetch_add( 1, std::memory_order_relaxed ) ) < numChunks; )
+			call( thread, chunk * chunkSize, std::min( count, ( chunk + 1 ) * chunkSize ) );
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve( numThreads - 1 );
+	for ( size_t i = 1; i < numThreads; ++i )
+		threads.emplace_back( worker, unsigned( i ) );
+
+	worker( 0u );
+
+	for ( auto &t : threads )
+		t.join();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Keeps the error with the lowest index reported from multiple threads
+class first_error final
+{
+public:
+	// Index of the first error reported so far, items past it can be skipped
+	size_t index() const noexcept { return _index.load( std::memory_order_relaxed ); }
+
+	void report( size_t index, const error &err )
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		if ( index < _index.load( std::memory_order_relaxed ) )
+		{
+			_error = err;
+			_index.store( index, std::memory_order_relaxed );
+		}
+	}
+
+	const error &get() const noexcept { return _error; }
+
+private:
+	std::mutex _mutex;
+	std::atomic<size_t> _index = size_t( -1 );
+	error _error;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Calls 'func( patternIndex, value )' for every match in document order, on the calling thread. Large arrays
+// are matched in parallel, matches of each chunk are collected and passed on in order of chunks.
+template <typename Func>
+inline void filter_parallel( const json5::value &in, const filter_program &program, const parallel_params &pp, const Func &func )
+{
+	using match = std::pair<size_t, json5::value>;
+
+	const size_t chunkSize = std::max<size_t>( pp.chunk_size, 1 );
+	filter_walker walker( program, in, chunkSize );
+
+	json5::value found;
+	size_t patternIndex = 0;
+	std::vector<std::vector<match>> chunks;
+
+	for ( ;; )
+	{
+		while ( walker.next( found, patternIndex ) )
+			func( patternIndex, found );
+
+		if ( !walker.split() )
+			break;
+
+		auto arr = array_view( walker.split_array() );
+		const auto *arraySet = walker.split_set();
+
+		chunks.clear();
+		chunks.resize( ( arr.size() + chunkSize - 1 ) / chunkSize );
+
+		// Document and program are immutable, each chunk has its own walker and output
+		parallel_for( arr.size(), pp, [&]( size_t begin, size_t end )
+		{
+			auto &out = chunks[begin / chunkSize];
+			std::vector<filter_program::word> itemSet( program.num_words() );
+			filter_walker itemWalker( program, json5::value(), itemSet.data() );
+
+			json5::value itemMatch;
+			size_t itemPattern = 0;
+
+			for ( size_t i = begin; i < end; ++i )
+			{
+				const auto &item = arr.begin()[i];
+				if ( !program.transition( arraySet, itemSet.data(), nullptr, i, arr.size(), item ) )
+					continue;
+
+				itemWalker.restart( item, itemSet.data() );
+				while ( itemWalker.next( itemMatch, itemPattern ) )
+					out.emplace_back( itemPattern, itemMatch );
+			}
+		} );
+
+		for ( const auto &chunk : chunks )
+			for ( const auto &m : chunk )
+				func( m.first, m.second );
+
+		walker.resume();
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Writes an array of 'count' items into 'str', as a stream_writer would. Items are written by 'func( writer, index )'
+// in chunks on multiple threads. Chunks are written at depth 1 into separate buffers, joined as raw values.
+template <typename Func>
+inline void to_string_array_parallel( std::string &str, size_t count, const writer_params &wp, const parallel_params &pp, const Func &func )
+{
+	const size_t chunkSize = std::max<size_t>( pp.chunk_size, 1 );
+	std::vector<std::string> chunks( ( count + chunkSize - 1 ) / chunkSize );
+
+	// Same as 'stream_writer::next_item' at depth 1
+	std::string separator = ",";
+	if ( !wp.compact )
+		separator.append( wp.eol ).append( wp.indentation );
+
+	JSON5_INSTRUMENT_FORK();
+
+	parallel_for( count, pp, [&]( size_t begin, size_t end )
+	{
+		JSON5_INSTRUMENT_WORKER( 1 );
+
+		string_ostream os( chunks[begin / chunkSize] );
+
+		for ( size_t i = begin; i < end; ++i )
+		{
+			if ( i != begin )
+				os << separator;
+
+			stream_writer w( os, wp, 1 );
+			func( w, i );
+		}
+
+		os.flush();
+	} );
+
+	size_t size = 0;
+	for ( const auto &text : chunks )
+		size += text.size() + separator.size();
+
+	str.clear();
+	str.reserve( size + 16 );
+
+	string_ostream os( str );
+	stream_writer w( os, wp );
+	w.begin_array();
+
+	// Chunks are empty if 'parallel_for' ran on a single thread, it passes the whole range at once
+	for ( const auto &text : chunks )
+		if ( !text.empty() )
+			w.raw_value( text );
+
+	w.end_array();
+	os.flush();
+}
+
+} // namespace detail
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename A>
+inline error from_document_parallel( const document &doc, std::vector<T, A> &out, const parallel_params &pp, size_t *errorIndex )
+{
+	static_assert( !std::is_same_v<T, bool>, "std::vector<bool> items can not be written from multiple threads" );
+
+	if ( !doc.is_array() && !doc.is_null() )
+		return { error::array_expected };
+
+	auto arr = json5::array_view( doc );
+
+	out.clear();
+	out.resize( arr.size() );
+
+	// Document is immutable and items are independent, each thread reads its own range of pre-sized storage
+	detail::first_error firstError;
+	detail::parallel_for( arr.size(), pp, [&]( size_t begin, size_t end )
+	{
+		for ( size_t i = begin; i < end && i < firstError.index(); ++i )
+		{
+			if ( auto err = detail::read( arr.begin()[i], out[i] ) )
+			{
+				firstError.report( i, err );
+				break;
+			}
+		}
+	} );
+
+	error result = firstError.get();
+	if ( result && errorIndex )
+		*errorIndex = firstError.index();
+
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<json5::value> filter_parallel( const json5::value &in, const compiled_filter &pattern, const parallel_params &pp )
+{
+	std::vector<json5::value> result;
+	detail::filter_parallel( in, pattern.program(), pp, [&result]( size_t, const json5::value & v )
+	{
+		JSON5_INSTRUMENT_GROWTH( filter, result );
+		result.push_back( v );
+	} );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<json5::value> filter_parallel( const json5::value &in, std::string_view pattern, const parallel_params &pp )
+{
+	return filter_parallel( in, compiled_filter( pattern ), pp );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<std::vector<json5::value>> filter_parallel( const json5::value &in, const filter_set &patterns, const parallel_params &pp )
+{
+	std::vector<std::vector<json5::value>> result( patterns.size() );
+	detail::filter_parallel( in, patterns.program(), pp, [&result]( size_t index, const json5::value & v )
+	{
+		JSON5_INSTRUMENT_GROWTH( filter, result[index] );
+		result[index].push_back( v );
+	} );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void to_string_parallel( std::string &str, const document &doc, const writer_params &wp, const parallel_params &pp )
+{
+	if ( !doc.is_array() || array_view( doc ).size() <= pp.chunk_size )
+	{
+		to_string( str, doc, wp );
+		return;
+	}
+
+	JSON5_INSTRUMENT_SCOPE( write );
+
+	auto arr = array_view( doc );
+	detail::to_string_array_parallel( str, arr.size(), wp, pp, [&arr]( stream_writer &w, size_t i ) { w.value( arr.begin()[i] ); } );
+
+	JSON5_INSTRUMENT_COUNT( bytes, str.size() );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::string to_string_parallel( const document &doc, const writer_params &wp, const parallel_params &pp )
+{
+	std::string result;
+	to_string_parallel( result, doc, wp, pp );
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename A>
+inline void to_string_parallel( std::string &str, const std::vector<T, A> &in, const writer_params &wp, const parallel_params &pp )
+{
+	if ( in.size() <= pp.chunk_size )
+	{
+		to_string( str, in, wp );
+		return;
+	}
+
+	JSON5_INSTRUMENT_SCOPE( write );
+
+	detail::to_string_array_parallel( str, in.size(), wp, pp, [&in]( stream_writer &w, size_t i ) { detail::write( w, in[i] ); } );
+
+	JSON5_INSTRUMENT_COUNT( bytes, str.size() );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+inline std::vector<std::string> to_string_parallel( std::span<const document> docs, const writer_params &wp, const parallel_params &pp )
+{
+	std::vector<std::string> result( docs.size() );
+
+	detail::parallel_for( docs.size(), pp, [&]( size_t begin, size_t end )
+	{
+		for ( size_t i = begin; i < end; ++i )
+			to_string( result[i], docs[i], wp );
+	} );
+
+	return result;
+}
+
+} // namespace json5
@@ -1,12 +1,26 @@
 #pragma once
 
 #include "json5_builder.hpp"
+#include "json5_input.hpp"
+#include "json5_output.hpp"
 
 #include <array>
+#include <bit>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <unordered_map>
 
+/*
+	By default, 'to_stream', 'to_string' and 'to_file' write reflected types directly as text through
+	json5::stream_writer, and 'from_string' and 'from_file' read text directly into reflected types.
+	Define JSON5_REFLECT_USE_DOCUMENT to go through a temporary json5::document instead.
+	'to_document' and 'from_document' always work with a document.
+
+	'std::string_view' and 'const char*' members point into the string storage of the document they were
+	read from. Read them through json5::document_holder, which keeps that document alive alongside the value.
+*/
+
 namespace json5 {
 
 //
@@ -27,12 +41,78 @@ template <typename T> bool to_file( const std::string &fileName, const T &in, co
 //
 template <typename T> error from_document( const document &doc, T &out );
 
-//
-template <typename T> error from_string( const std::string &str, T &out );
+// Reads 'out' from text in memory, which is not copied
+template <typename T> error from_string( std::string_view str, T &out );
 
 //
 template <typename T> error from_file( const std::string &fileName, T &out );
 
+// Reads 'out' from 'doc' in reuse mode: existing vector elements and map nodes in 'out' are updated in place
+template <typename T> error update_from_document( const document &doc, T &out );
+
+// Parses 'str' into 'doc' (reusing its storage) and updates 'out' from it
+template <typename T> error update_from_string( const std::string &str, document &doc, T &out );
+
+// Parses 'str' into 'doc' reusing scratch buffers of 'context', then updates 'out'. Does not allocate once warmed up.
+template <typename T> error update_from_string( std::string_view str, document &doc, parse_context &context, T &out );
+
+// Parses file into 'doc' (reusing its storage) and updates 'out' from it
+template <typename T> error update_from_file( const std::string &fileName, document &doc, T &out );
+
+/*
+	Owns a json5::document together with a value read from it, so that 'std::string_view' and 'const char*'
+	members of the value stay valid for as long as the holder does. The document is heap allocated,
+	moving a holder does not move its strings. A moved-from holder gets a new document when it is read into again.
+*/
+template <typename T>
+class document_holder final
+{
+public:
+	document_holder() : _doc( std::make_unique<document>() ) { }
+	document_holder( document_holder && ) noexcept = default;
+	document_holder &operator=( document_holder && ) noexcept = default;
+
+	document_holder( const document_holder & ) = delete;
+	document_holder &operator=( const document_holder & ) = delete;
+
+	T &get() noexcept { return _value; }
+	const T &get() const noexcept { return _value; }
+
+	T &operator*() noexcept { return _value; }
+	const T &operator*() const noexcept { return _value; }
+
+	T *operator->() noexcept { return &_value; }
+	const T *operator->() const noexcept { return &_value; }
+
+	const document &doc() const noexcept { return *_doc; }
+
+private:
+	std::unique_ptr<document> _doc;
+	T _value = T();
+
+	// Document to read into, recreated after the holder was moved from
+	document &target()
+	{
+		if ( !_doc )
+			_doc = std::make_unique<document>();
+
+		return *_doc;
+	}
+
+	template <typename U> friend error from_document( document &&doc, document_holder<U> &out );
+	template <typename U> friend error from_string( std::string_view str, document_holder<U> &out );
+	template <typename U> friend error from_file( const std::string &fileName, document_holder<U> &out );
+};
+
+// Takes ownership of 'doc' and reads 'out' from it
+template <typename T> error from_document( document &&doc, document_holder<T> &out );
+
+//
+template <typename T> error from_string( std::string_view str, document_holder<T> &out );
+
+//
+template <typename T> error from_file( const std::string &fileName, document_holder<T> &out );
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace detail {
@@ -51,24 +131,6 @@ private:
 	writer_params _params;
 };
 
-//---------------------------------------------------------------------------------------------------------------------
-inline std::string_view get_name_slice( const char *names, size_t index )
-{
-	size_t numCommas = index;
-	while ( numCommas > 0 && *names )
-		if ( *names++ == ',' )
-			--numCommas;
-
-	while ( *names && *names <= 32 )
-		++names;
-
-	size_t length = 0;
-	while ( names[length] > 32 && names[length] != ',' )
-		++length;
-
-	return std::string_view( names, length );
-}
-
 /* Forward declarations */
 template <typename T> json5::value write( writer &w, const T &in );
 
@@ -80,6 +142,7 @@ inline json5::value write( writer &w, float in ) { return json5::value( double(
 inline json5::value write( writer &w, double in ) { return json5::value( in ); }
 inline json5::value write( writer &w, const char *in ) { return w.new_string( in ); }
 inline json5::value write( writer &w, const std::string &in ) { return w.new_string( in ); }
+inline json5::value write( writer &w, std::string_view in ) { return w.new_string( in ); }
 
 //---------------------------------------------------------------------------------------------------------------------
 template <typename T>
@@ -128,56 +191,143 @@ inline json5::value write( writer &w, const std::unordered_map<K, T, H, EQ, A> &
 template <typename T>
 inline json5::value write_enum( writer &w, T in )
 {
-	size_t index = 0;
-	const auto *names = enum_table<T>::names;
-	const auto *values = enum_table<T>::values;
+	if ( size_t index = enum_table<T>::index.find( in ); index < enum_table<T>::names.size() )
+		return w.new_string( enum_table<T>::names[index] );
 
-	while ( true )
-	{
-		auto name = get_name_slice( names, index );
+	// Underlying value fallback
+	return write( w, std::underlying_type_t<T>( in ) );
+}
 
-		// Underlying value fallback
-		if ( name.empty() )
-			return write( w, std::underlying_type_t<T>( in ) );
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t N, typename... Types, size_t... Is>
+inline void write_tuple( writer &w, const name_table<N> &names, const std::tuple<Types...> &t, std::index_sequence<Is...> )
+{
+	( ( names[Is].empty() || ( w[names[Is]] = write( w, std::get<Is>( t ) ), true ) ), ... );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t Index = 0, typename... Types>
+inline void write_named_tuple( writer &w, const std::tuple<Types...> &t )
+{
+	const auto &members = std::get < Index + 1 > ( t );
+	write_tuple( w, *std::get<Index>( t ), members, std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<decltype( members )>>>() );
 
-		if ( in == values[index] )
-			return w.new_string( name );
+	if constexpr ( Index + 2 != sizeof...( Types ) )
+		write_named_tuple < Index + 2 > ( w, t );
+}
 
-		++index;
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline json5::value write( writer &w, const T &in )
+{
+	if constexpr ( std::is_enum_v<T> )
+	{
+		if constexpr ( enum_table<T>() )
+			return write_enum( w, in );
+		else
+			return write( w, std::underlying_type_t<T>( in ) );
 	}
+	else if constexpr ( std::is_arithmetic_v<T> )
+		return json5::value( double( in ) );
+	else
+	{
+		w.push_object();
+		write_named_tuple( w, class_wrapper<T>::make_named_tuple( in ) );
+		return w.pop();
+	}
+}
 
-	return json5::value();
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Checks, if type has reflection generated by JSON5_MEMBERS or JSON5_CLASS
+template <typename T, typename = void> struct has_members : std::false_type { };
+template <typename T> struct has_members<T, std::void_t<decltype( std::declval<const T &>().make_named_tuple() )>> : std::true_type { };
+template <typename T, typename = void> struct has_class_wrapper : std::false_type { };
+template <typename T> struct has_class_wrapper<T, std::void_t<decltype( class_wrapper<T>::names )>> : std::true_type { };
+template <typename T> constexpr bool is_reflected_v = has_members<T>::value || has_class_wrapper<T>::value;
+
+/* Forward declarations */
+template <typename T> void write( stream_writer &w, const T &in );
+template <typename T, typename A> void write( stream_writer &w, const std::vector<T, A> &in );
+template <typename T, size_t N> void write( stream_writer &w, const T( &in )[N] );
+template <typename T, size_t N> void write( stream_writer &w, const std::array<T, N> &in );
+template <typename K, typename T, typename P, typename A> void write( stream_writer &w, const std::map<K, T, P, A> &in );
+template <typename K, typename T, typename H, typename EQ, typename A> void write( stream_writer &w, const std::unordered_map<K, T, H, EQ, A> &in );
+
+//---------------------------------------------------------------------------------------------------------------------
+inline void write( stream_writer &w, const char *in ) { w.value( in ); }
+inline void write( stream_writer &w, const std::string &in ) { w.value( in ); }
+inline void write( stream_writer &w, std::string_view in ) { w.value( in ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void write_array( stream_writer &w, const T *in, size_t numItems )
+{
+	w.begin_array();
+
+	for ( size_t i = 0; i < numItems; ++i )
+		write( w, in[i] );
+
+	w.end_array();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-template <size_t Index = 0, typename... Types>
-inline void write_tuple( writer &w, const char *names, const std::tuple<Types...> &t )
+template <typename T, typename A>
+inline void write( stream_writer &w, const std::vector<T, A> &in ) { write_array( w, in.data(), in.size() ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline void write( stream_writer &w, const T( &in )[N] ) { write_array( w, in, N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline void write( stream_writer &w, const std::array<T, N> &in ) { write_array( w, in.data(), N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void write_map( stream_writer &w, const T &in )
 {
-	const auto &in = std::get<Index>( t );
-	using Type = std::remove_const_t<std::remove_reference_t<decltype( in )>>;
+	w.begin_object();
 
-	if ( auto name = get_name_slice( names, Index ); !name.empty() )
+	for ( const auto &kvp : in )
 	{
-		if constexpr ( std::is_enum_v<Type> )
-		{
-			if constexpr ( enum_table<Type>() )
-				w[name] = write_enum( w, in );
-			else
-				w[name] = write( w, std::underlying_type_t<Type>( in ) );
-		}
-		else
-			w[name] = write( w, in );
+		w.key( kvp.first );
+		write( w, kvp.second );
 	}
 
-	if constexpr ( Index + 1 != sizeof...( Types ) )
-		write_tuple < Index + 1 > ( w, names, t );
+	w.end_object();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename K, typename T, typename P, typename A>
+inline void write( stream_writer &w, const std::map<K, T, P, A> &in ) { write_map( w, in ); }
+
+template <typename K, typename T, typename H, typename EQ, typename A>
+inline void write( stream_writer &w, const std::unordered_map<K, T, H, EQ, A> &in ) { write_map( w, in ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void write_enum( stream_writer &w, T in )
+{
+	if ( size_t index = enum_table<T>::index.find( in ); index < enum_table<T>::names.size() )
+		w.value( enum_table<T>::names[index] );
+	else
+		w.value( std::underlying_type_t<T>( in ) ); // Underlying value fallback
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t N, typename... Types, size_t... Is>
+inline void write_tuple( stream_writer &w, const name_table<N> &names, const std::tuple<Types...> &t, std::index_sequence<Is...> )
+{
+	( ( names[Is].empty() || ( write( w.key( names[Is] ), std::get<Is>( t ) ), true ) ), ... );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 template <size_t Index = 0, typename... Types>
-inline void write_named_tuple( writer &w, const std::tuple<Types...> &t )
+inline void write_named_tuple( stream_writer &w, const std::tuple<Types...> &t )
 {
-	write_tuple( w, std::get<Index>( t ), std::get < Index + 1 > ( t ) );
+	const auto &members = std::get < Index + 1 > ( t );
+	write_tuple( w, *std::get<Index>( t ), members, std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<decltype( members )>>>() );
 
 	if constexpr ( Index + 2 != sizeof...( Types ) )
 		write_named_tuple < Index + 2 > ( w, t );
@@ -185,17 +335,42 @@ inline void write_named_tuple( writer &w, const std::tuple<Types...> &t )
 
 //---------------------------------------------------------------------------------------------------------------------
 template <typename T>
-inline json5::value write( writer &w, const T &in )
+inline void write( stream_writer &w, const T &in )
 {
-	w.push_object();
-	write_named_tuple( w, class_wrapper<T>::make_named_tuple( in ) );
-	return w.pop();
+	if constexpr ( std::is_enum_v<T> )
+	{
+		if constexpr ( enum_table<T>() )
+			write_enum( w, in );
+		else
+			w.value( std::underlying_type_t<T>( in ) );
+	}
+	else if constexpr ( std::is_arithmetic_v<T> )
+		w.value( in );
+	else if constexpr ( is_reflected_v<T> )
+	{
+		w.begin_object();
+		write_named_tuple( w, class_wrapper<T>::make_named_tuple( in ) );
+		w.end_object();
+	}
+	else
+	{
+		// Types with custom 'write( writer &, const T & )' only: build a small document and stream it.
+		// Wrapping the value in an array makes the builder relink strings on 'pop'.
+		document doc;
+		writer dw( doc, w.params() );
+		dw.push_array();
+		dw += write( dw, in );
+		dw.pop();
+		w.value( array_view( doc )[0] );
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* Forward declarations */
 template <typename T> error read( const json5::value &in, T &out );
+template <typename T, size_t N> error read( const json5::value &in, T( &out )[N] );
+template <typename T, size_t N> error read( const json5::value &in, std::array<T, N> &out );
 
 //---------------------------------------------------------------------------------------------------------------------
 inline error read( const json5::value &in, bool &out )
@@ -230,6 +405,16 @@ inline error read( const json5::value &in, const char *&out )
 	return { error::none };
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+inline error read( const json5::value &in, std::string_view &out )
+{
+	if ( !in.is_string() )
+		return { error::string_expected };
+
+	out = in.get_c_str();
+	return { error::none };
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 inline error read( const json5::value &in, std::string &out )
 {
@@ -240,6 +425,33 @@ inline error read( const json5::value &in, std::string &out )
 	return { error::none };
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+constexpr bool is_bulk_number_v = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool all_numbers( const json5::array_view &arr ) noexcept
+{
+	// No early exit, so the sweep stays branch free
+	bool result = true;
+	for ( const auto &i : arr )
+		result &= i.is_number();
+
+	return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline void convert_numbers( const json5::array_view &arr, T *out ) noexcept
+{
+	static_assert( sizeof( json5::value ) == sizeof( double ) && std::is_trivially_copyable_v<json5::value> );
+
+	// Every item is known to be a number, read the double bits without checking them again
+	const json5::value *src = arr.begin();
+	for ( size_t i = 0, n = arr.size(); i < n; ++i )
+		out[i] = T( std::bit_cast<double>( src[i] ) );
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 template <typename T>
 inline error read_array( const json5::value &in, T *out, size_t numItems )
@@ -251,6 +463,15 @@ inline error read_array( const json5::value &in, T *out, size_t numItems )
 	if ( arr.size() != numItems )
 		return { error::wrong_array_size };
 
+	if constexpr ( is_bulk_number_v<T> )
+	{
+		if ( !all_numbers( arr ) )
+			return { error::number_expected };
+
+		convert_numbers( arr, out );
+		return { error::none };
+	}
+
 	for ( size_t i = 0; i < numItems; ++i )
 		if ( auto err = read( arr[i], out[i] ) )
 			return err;
@@ -275,6 +496,16 @@ inline error read( const json5::value &in, std::vector<T, A> &out )
 
 	auto arr = json5::array_view( in );
 
+	if constexpr ( is_bulk_number_v<T> )
+	{
+		if ( !all_numbers( arr ) )
+			return { error::number_expected };
+
+		out.resize( arr.size() );
+		convert_numbers( arr, out.data() );
+		return { error::none };
+	}
+
 	out.clear();
 	out.reserve( arr.size() );
 	for ( const auto &i : arr )
@@ -321,118 +552,591 @@ inline error read_enum( const json5::value &in, T &out )
 	if ( !in.is_string() && !in.is_number() )
 		return { error::string_expected };
 
-	size_t index = 0;
-	const auto *names = enum_table<T>::names;
-	const auto *values = enum_table<T>::values;
+	size_t index = in.is_string()
+	               ? enum_table<T>::names.find( in.get_c_str() )
+	               : enum_table<T>::index.find( T( in.get<std::underlying_type_t<T>>() ) );
 
-	while ( true )
+	if ( index >= enum_table<T>::names.size() )
+		return { error::invalid_enum };
+
+	out = enum_table<T>::values[index];
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t Index, typename Source, typename Tuple>
+inline error read_tuple_item( Source &in, Tuple &t )
+{
+	return read( in, std::get<Index>( t ) );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Read tuple item selected by runtime 'index' through a table of per-member read functions
+template <typename Source, typename Tuple, size_t... Is>
+inline error read_tuple_item( Source &in, size_t index, Tuple &t, std::index_sequence<Is...> )
+{
+	using read_func = error( * )( Source &, Tuple & );
+	static constexpr read_func table[] = { &read_tuple_item<Is, Source, Tuple>... };
+	return table[index]( in, t );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Find member named 'key' (through the hashed name tables) and read it, sets 'found' on success
+template <size_t Index = 0, typename Source, typename Tuple>
+inline error read_named_tuple( Source &in, std::string_view key, Tuple &t, bool &found )
+{
+	auto &members = std::get < Index + 1 > ( t );
+	constexpr size_t numMembers = std::tuple_size_v<std::remove_reference_t<decltype( members )>>;
+
+	if ( size_t index = std::get<Index>( t )->find( key ); index < numMembers )
 	{
-		auto name = get_name_slice( names, index );
+		found = true;
+		return read_tuple_item( in, index, members, std::make_index_sequence<numMembers>() );
+	}
 
-		if ( name.empty() )
-			break;
+	if constexpr ( Index + 2 != std::tuple_size_v<Tuple> )
+		return read_named_tuple < Index + 2 > ( in, key, t, found );
+
+	return { error::none };
+}
 
-		if ( in.is_string() && name == in.get_c_str() )
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read( const json5::value &in, T &out )
+{
+	if constexpr ( std::is_enum_v<T> )
+	{
+		if constexpr ( enum_table<T>() )
+			return read_enum( in, out );
+		else
 		{
-			out = values[index];
+			std::underlying_type_t<T> temp;
+			if ( auto err = read_number( in, temp ) )
+				return err;
+
+			out = T( temp );
 			return { error::none };
 		}
-		else if ( in.is_number() && in.get<int>() == int( values[index] ) )
+	}
+	else if constexpr ( std::is_arithmetic_v<T> )
+		return read_number( in, out );
+	else
+	{
+		if ( !in.is_object() )
+			return { error::object_expected };
+
+		auto namedTuple = class_wrapper<T>::make_named_tuple( out );
+
+		// Single pass over the object, unknown keys are ignored
+		for ( auto kvp : json5::object_view( in ) )
 		{
-			out = values[index];
-			return { error::none };
+			bool found = false;
+			if ( auto err = read_named_tuple( kvp.second, kvp.first, namedTuple, found ) )
+				return err;
 		}
 
-		++index;
+		return { error::none };
 	}
+}
 
-	return { error::invalid_enum };
+//---------------------------------------------------------------------------------------------------------------------
+template <size_t Index = 0, typename Head, typename... Tail>
+inline error read( const json5::array_view &arr, Head &out, Tail &... tail )
+{
+	if constexpr ( Index == 0 )
+	{
+		if ( !arr.is_valid() )
+			return { error::array_expected };
+
+		if ( arr.size() != ( 1 + sizeof...( Tail ) ) )
+			return { error::wrong_array_size };
+	}
+
+	if ( auto err = read( arr[Index], out ) )
+		return err;
+
+	if constexpr ( sizeof...( Tail ) > 0 )
+		return read < Index + 1 > ( arr, tail... );
+
+	return { error::none };
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Value read in reuse mode. Vector elements and map nodes already present in the destination are updated
+	in place, so repeated reads into a long-lived object keep their allocations. Like any read into an existing
+	object, members missing from the input keep their previous values, in the object itself and in values of
+	map keys which are still present. Array items and recycled map nodes are reset first, unless a read
+	replaces them completely (see 'read_overwrites'). Types without a reuse overload are read normally.
+*/
+struct reuse_value final
+{
+	const json5::value &in;
+};
+
+template <typename T, typename = void> struct has_reserve : std::false_type { };
+template <typename T> struct has_reserve<T, std::void_t<decltype( std::declval<T &>().reserve( size_t() ) )>> : std::true_type { };
+
+// Types which a read in reuse mode replaces completely, so a value left over from another map key or array item
+// can be read into as it is. Other values are reset first.
+template <typename T> struct read_overwrites : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>> { };
+template <typename C, typename TR, typename A> struct read_overwrites<std::basic_string<C, TR, A>> : std::true_type { };
+template <typename T, typename A> struct read_overwrites<std::vector<T, A>> : read_overwrites<T> { };
+template <typename T, size_t N> struct read_overwrites<std::array<T, N>> : read_overwrites<T> { };
+template <typename K, typename T, typename P, typename A> struct read_overwrites<std::map<K, T, P, A>> : read_overwrites<T> { };
+template <typename K, typename T, typename H, typename EQ, typename A>
+struct read_overwrites<std::unordered_map<K, T, H, EQ, A>> : read_overwrites<T> { };
+
+/* Forward declarations */
+template <typename T> error read( const reuse_value &in, T &out );
+template <typename T, size_t N> error read( const reuse_value &in, T( &out )[N] );
+template <typename T, size_t N> error read( const reuse_value &in, std::array<T, N> &out );
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_array( const reuse_value &in, T *out, size_t numItems )
+{
+	if constexpr ( is_bulk_number_v<T> )
+		return read_array( in.in, out, numItems );
+	else
+	{
+		if ( !in.in.is_array() )
+			return { error::array_expected };
+
+		auto arr = json5::array_view( in.in );
+		if ( arr.size() != numItems )
+			return { error::wrong_array_size };
+
+		for ( size_t i = 0; i < numItems; ++i )
+		{
+			if constexpr ( !read_overwrites<T>::value )
+				out[i] = T();
+
+			if ( auto err = read( reuse_value{ arr.begin()[i] }, out[i] ) )
+				return err;
+		}
+
+		return { error::none };
+	}
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-template <size_t Index = 0, typename... Types>
-inline error read_tuple( const json5::object_view &obj, const char *names, std::tuple<Types...> &t )
+template <typename T, size_t N>
+inline error read( const reuse_value &in, T( &out )[N] ) { return read_array( in, out, N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline error read( const reuse_value &in, std::array<T, N> &out ) { return read_array( in, out.data(), N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename A>
+inline error read( const reuse_value &in, std::vector<T, A> &out )
+{
+	// Bulk numeric read already resizes in place
+	if constexpr ( is_bulk_number_v<T> )
+		return read( in.in, out );
+	else
+	{
+		if ( !in.in.is_array() && !in.in.is_null() )
+			return { error::array_expected };
+
+		auto arr = json5::array_view( in.in );
+
+		// Keep existing elements (and whatever they own), only construct or destroy the difference
+		out.resize( arr.size() );
+		for ( size_t i = 0; i < out.size(); ++i )
+		{
+			// The element may hold a different record than before, it must not fill in members missing from the input
+			if constexpr ( !read_overwrites<T>::value )
+				out[i] = T();
+
+			if ( auto err = read( reuse_value{ arr.begin()[i] }, out[i] ) )
+				return err;
+		}
+
+		return { error::none };
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_map( const reuse_value &in, T &out )
 {
-	auto &out = std::get<Index>( t );
-	using Type = std::remove_reference_t<decltype( out )>;
+	if ( !in.in.is_object() && !in.in.is_null() )
+		return { error::object_expected };
 
-	auto name = get_name_slice( names, Index );
+	auto obj = json5::object_view( in.in );
+	typename T::key_type key;
 
-	auto iter = obj.find( name );
-	if ( iter != obj.end() )
+	// Common case, same keys in the same order as before: update mapped values in place
+	if ( obj.size() == out.size() )
 	{
-		if constexpr ( std::is_enum_v<Type> )
+		auto iter = out.begin();
+		for ( auto jsKV : obj )
 		{
-			if constexpr ( enum_table<Type>() )
+			// String keys are compared in place, so long keys are not copied on every read
+			if constexpr ( std::is_same_v<typename T::key_type, std::string> )
 			{
-				if ( auto err = read_enum( ( *iter ).second, out ) )
-					return err;
+				if ( iter->first != jsKV.first )
+					break;
 			}
 			else
 			{
-				std::underlying_type_t<Type> temp;
-				if ( auto err = read( ( *iter ).second, temp ) )
-					return err;
-
-				out = Type( temp );
+				key = jsKV.first;
+				if ( !( iter->first == key ) )
+					break;
 			}
+
+			if ( auto err = read( reuse_value{ jsKV.second }, iter->second ) )
+				return err;
+
+			++iter;
 		}
-		else
+
+		if ( iter == out.end() )
+			return { error::none };
+	}
+
+	// Keys have changed (or come in a different order). Buckets are reserved on the live map, so they are kept.
+	if constexpr ( has_reserve<T>::value )
+		out.reserve( obj.size() );
+
+	// Scratch arrays live on the stack for small maps, like in object_view comparison
+	static constexpr size_t stack_node_count = 64;
+	const void *tempPresent[stack_node_count];
+	typename T::node_type tempRemoved[stack_node_count];
+	std::vector<const void *> heapPresent;
+	std::vector<typename T::node_type> heapRemoved;
+
+	const void **present = tempPresent;
+	if ( obj.size() > stack_node_count )
+	{
+		heapPresent.resize( obj.size() );
+		present = heapPresent.data();
+	}
+
+	auto *removed = tempRemoved;
+	if ( out.size() > stack_node_count )
+	{
+		heapRemoved.resize( out.size() );
+		removed = heapRemoved.data();
+	}
+
+	// Nodes of keys which are still present. A key given twice reaches the same node twice.
+	size_t numPresent = 0;
+	for ( auto jsKV : obj )
+	{
+		key = jsKV.first;
+		if ( auto iter = out.find( key ); iter != out.end() )
+			present[numPresent++] = &*iter;
+	}
+
+	std::sort( present, present + numPresent );
+
+	// Set nodes of removed keys aside, so they can be recycled for new keys
+	size_t numRemoved = 0;
+	for ( auto iter = out.begin(); iter != out.end(); )
+	{
+		auto node = iter++;
+		if ( !std::binary_search( present, present + numPresent, static_cast<const void *>( &*node ) ) )
+			removed[numRemoved++] = out.extract( node );
+	}
+
+	// Keys already present (or added by an earlier duplicate) are updated in place, new keys take a recycled node
+	for ( auto jsKV : obj )
+	{
+		key = jsKV.first;
+
+		if ( auto iter = out.find( key ); iter != out.end() )
 		{
-			if ( auto err = read( ( *iter ).second, out ) )
+			if ( auto err = read( reuse_value{ jsKV.second }, iter->second ) )
 				return err;
 		}
+		else if ( numRemoved > 0 )
+		{
+			auto &node = removed[--numRemoved];
+			node.key() = key;
+
+			// Values of the removed key must not fill in members missing from the new key's input
+			if constexpr ( !read_overwrites<typename T::mapped_type>::value )
+				node.mapped() = typename T::mapped_type();
+
+			if ( auto err = read( reuse_value{ jsKV.second }, node.mapped() ) )
+				return err;
+
+			out.insert( std::move( node ) );
+		}
+		else if ( auto err = read( reuse_value{ jsKV.second }, out.try_emplace( key ).first->second ) )
+			return err;
 	}
 
-	if constexpr ( Index + 1 != sizeof...( Types ) )
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename K, typename T, typename P, typename A>
+inline error read( const reuse_value &in, std::map<K, T, P, A> &out ) { return read_map( in, out ); }
+
+template <typename K, typename T, typename H, typename EQ, typename A>
+inline error read( const reuse_value &in, std::unordered_map<K, T, H, EQ, A> &out ) { return read_map( in, out ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read( const reuse_value &in, T &out )
+{
+	if constexpr ( is_reflected_v<T> )
 	{
-		if ( auto err = read_tuple < Index + 1 > ( obj, names, t ) )
-			return err;
+		if ( !in.in.is_object() )
+			return { error::object_expected };
+
+		auto namedTuple = class_wrapper<T>::make_named_tuple( out );
+
+		for ( auto kvp : json5::object_view( in.in ) )
+		{
+			const reuse_value item{ kvp.second };
+			bool found = false;
+			if ( auto err = read_named_tuple( item, kvp.first, namedTuple, found ) )
+				return err;
+		}
+
+		return { error::none };
 	}
+	else
+		return read( in.in, out );
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Forward declarations */
+template <typename T> error read( stream_reader &r, T &out );
+template <typename T, size_t N> error read( stream_reader &r, T( &out )[N] );
+template <typename T, size_t N> error read( stream_reader &r, std::array<T, N> &out );
 
+//---------------------------------------------------------------------------------------------------------------------
+inline error read( stream_reader &r, bool &out ) { return r.read_bool( out ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_number( stream_reader &r, T &out )
+{
+	double number = 0.0;
+	if ( auto err = r.read_number( number ) )
+		return err;
+
+	out = T( number );
 	return { error::none };
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-template <size_t Index = 0, typename Tuple>
-inline error read_named_tuple( const json5::object_view &obj, Tuple &t )
+inline error read( stream_reader &r, std::string &out )
 {
-	return read_tuple( obj, std::get<Index>( t ), std::get < Index + 1 > ( t ) );
+	std::string_view str;
+	if ( auto err = r.read_string( str ) )
+		return err;
+
+	out = str;
+	return { error::none };
 }
 
+// There is no document to point into, read from a json5::document instead
+error read( stream_reader &r, const char *&out ) = delete;
+error read( stream_reader &r, std::string_view &out ) = delete;
+
 //---------------------------------------------------------------------------------------------------------------------
 template <typename T>
-inline error read( const json5::value &in, T &out )
+inline error read_array( stream_reader &r, T *out, size_t numItems )
 {
-	if ( !in.is_object() )
-		return { error::object_expected };
+	if ( auto err = r.begin_array() )
+		return err;
 
-	auto namedTuple = class_wrapper<T>::make_named_tuple( out );
-	return read_named_tuple( json5::object_view( in ), namedTuple );
+	for ( size_t i = 0; ; ++i )
+	{
+		bool done = false;
+		if ( auto err = r.next_item( i, done ) )
+			return err;
+
+		if ( done )
+			return ( i == numItems ) ? error() : r.make_error( error::wrong_array_size );
+
+		if ( i == numItems )
+			return r.make_error( error::wrong_array_size );
+
+		if ( auto err = read( r, out[i] ) )
+			return err;
+	}
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-template <size_t Index = 0, typename Head, typename... Tail>
-inline error read( const json5::array_view &arr, Head &out, Tail &... tail )
+template <typename T, size_t N>
+inline error read( stream_reader &r, T( &out )[N] ) { return read_array( r, out, N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t N>
+inline error read( stream_reader &r, std::array<T, N> &out ) { return read_array( r, out.data(), N ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename A>
+inline error read( stream_reader &r, std::vector<T, A> &out )
 {
-	if constexpr ( Index == 0 )
+	bool isNull = false;
+	if ( auto err = r.begin_array( &isNull ) )
+		return err;
+
+	out.clear();
+
+	for ( size_t i = 0; !isNull; ++i )
 	{
-		if ( !arr.is_valid() )
-			return { error::array_expected };
+		bool done = false;
+		if ( auto err = r.next_item( i, done ) )
+			return err;
 
-		if ( arr.size() != ( 1 + sizeof...( Tail ) ) )
-			return { error::wrong_array_size };
+		if ( done )
+			break;
+
+		if ( auto err = read( r, out.emplace_back() ) )
+			return err;
 	}
 
-	if ( auto err = read( arr[Index], out ) )
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_map( stream_reader &r, T &out )
+{
+	bool isNull = false;
+	if ( auto err = r.begin_object( &isNull ) )
 		return err;
 
-	if constexpr ( sizeof...( Tail ) > 0 )
-		return read < Index + 1 > ( arr, tail... );
+	out.clear();
+
+	std::string_view key;
+	for ( size_t i = 0; !isNull; ++i )
+	{
+		bool done = false;
+		if ( auto err = r.next_key( i, key, done ) )
+			return err;
+
+		if ( done )
+			break;
+
+		std::pair<typename T::key_type, typename T::mapped_type> kvp;
+		kvp.first = key;
+
+		if ( auto err = read( r, kvp.second ) )
+			return err;
+
+		out.emplace( std::move( kvp ) );
+	}
 
 	return { error::none };
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+template <typename K, typename T, typename P, typename A>
+inline error read( stream_reader &r, std::map<K, T, P, A> &out ) { return read_map( r, out ); }
+
+template <typename K, typename T, typename H, typename EQ, typename A>
+inline error read( stream_reader &r, std::unordered_map<K, T, H, EQ, A> &out ) { return read_map( r, out ); }
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read_enum( stream_reader &r, T &out )
+{
+	using token_type = stream_reader::token_type;
+
+	token_type tt = token_type::unknown;
+	if ( auto err = r.peek_next_token( tt ) )
+		return err;
+
+	std::string_view str;
+	double number = 0.0;
+
+	if ( tt == token_type::string )
+	{
+		if ( auto err = r.read_string( str ) )
+			return err;
+	}
+	else if ( tt == token_type::number )
+	{
+		if ( auto err = r.read_number( number ) )
+			return err;
+	}
+	else
+		return r.make_error( error::string_expected );
+
+	size_t index = ( tt == token_type::string )
+	               ? enum_table<T>::names.find( str )
+	               : enum_table<T>::index.find( T( std::underlying_type_t<T>( number ) ) );
+
+	if ( index >= enum_table<T>::names.size() )
+		return r.make_error( error::invalid_enum );
+
+	out = enum_table<T>::values[index];
+	return { error::none };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error read( stream_reader &r, T &out )
+{
+	if constexpr ( std::is_enum_v<T> )
+	{
+		if constexpr ( enum_table<T>() )
+			return read_enum( r, out );
+		else
+		{
+			std::underlying_type_t<T> temp;
+			if ( auto err = read_number( r, temp ) )
+				return err;
+
+			out = T( temp );
+			return { error::none };
+		}
+	}
+	else if constexpr ( std::is_arithmetic_v<T> )
+		return read_number( r, out );
+	else if constexpr ( is_reflected_v<T> )
+	{
+		if ( auto err = r.begin_object() )
+			return err;
+
+		auto namedTuple = class_wrapper<T>::make_named_tuple( out );
+
+		std::string_view key;
+		for ( size_t i = 0; ; ++i )
+		{
+			bool done = false;
+			if ( auto err = r.next_key( i, key, done ) )
+				return err;
+
+			if ( done )
+				return { error::none };
+
+			bool found = false;
+			if ( auto err = read_named_tuple( r, key, namedTuple, found ) )
+				return err;
+
+			// Unknown keys are ignored
+			if ( !found )
+			{
+				if ( auto err = r.skip_value() )
+					return err;
+			}
+		}
+	}
+	else
+	{
+		// Types with custom 'read( const json5::value &, T & )' only: parse the value into a small document
+		document doc;
+		if ( auto err = r.parse_element( doc ) )
+			return err;
+
+		return read( array_view( doc )[0], out );
+	}
+}
+
 } // namespace detail
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -449,18 +1153,34 @@ inline void to_document( document &doc, const T &in, const writer_params &wp )
 template <typename T>
 inline void to_stream( std::ostream &os, const T &in, const writer_params &wp )
 {
+	JSON5_INSTRUMENT_SCOPE( write );
+	JSON5_INSTRUMENT_OUTPUT( os );
+
+#if defined(JSON5_REFLECT_USE_DOCUMENT)
 	document doc;
 	to_document( doc, in, wp );
 	to_stream( os, doc, wp );
+#else
+	stream_writer w( os, wp );
+	detail::write( w, in );
+#endif
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 template <typename T>
 inline void to_string( std::string &str, const T &in, const writer_params &wp )
 {
+#if defined(JSON5_REFLECT_USE_DOCUMENT)
 	document doc;
-	to_document( doc, in );
+	to_document( doc, in, wp );
 	to_string( str, doc, wp );
+#else
+	str.clear();
+
+	detail::string_ostream os( str );
+	to_stream( os, in, wp );
+	os.flush();
+#endif
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -492,24 +1212,114 @@ inline error from_document( const document &doc, T &out )
 
 //---------------------------------------------------------------------------------------------------------------------
 template <typename T>
-inline error from_string( const std::string &str, T &out )
+inline error from_string( std::string_view str, T &out )
 {
+	JSON5_INSTRUMENT_SCOPE( parse );
+
+#if defined(JSON5_REFLECT_USE_DOCUMENT)
 	document doc;
-	if ( auto err = from_string( str, doc ) )
+	parse_context context;
+	if ( auto err = from_string( str, doc, context ) )
 		return err;
 
 	return from_document( doc, out );
+#else
+	detail::memory_source src( str );
+	detail::stream_reader r( src );
+	return detail::read( r, out );
+#endif
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 template <typename T>
 inline error from_file( const std::string &fileName, T &out )
 {
+	JSON5_INSTRUMENT_SCOPE( parse );
+
+#if defined(JSON5_REFLECT_USE_DOCUMENT)
 	document doc;
 	if ( auto err = from_file( fileName, doc ) )
 		return err;
 
 	return from_document( doc, out );
+#else
+	std::ifstream ifs( fileName );
+	if ( !ifs.is_open() )
+		return error{ error::could_not_open, 0, 0 };
+
+	detail::stl_istream src( ifs );
+	detail::stream_reader r( src );
+	return detail::read( r, out );
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error update_from_document( const document &doc, T &out )
+{
+	return detail::read( detail::reuse_value{ doc }, out );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error update_from_string( const std::string &str, document &doc, T &out )
+{
+	if ( auto err = from_string( str, doc ) )
+		return err;
+
+	return update_from_document( doc, out );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error update_from_string( std::string_view str, document &doc, parse_context &context, T &out )
+{
+	if ( auto err = from_string( str, doc, context ) )
+		return err;
+
+	return update_from_document( doc, out );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error update_from_file( const std::string &fileName, document &doc, T &out )
+{
+	if ( auto err = from_file( fileName, doc ) )
+		return err;
+
+	return update_from_document( doc, out );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error from_document( document &&doc, document_holder<T> &out )
+{
+	out.target() = std::move( doc );
+	out._value = T();
+	return from_document( *out._doc, out._value );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error from_string( std::string_view str, document_holder<T> &out )
+{
+	parse_context context;
+	out._value = T();
+	if ( auto err = from_string( str, out.target(), context ) )
+		return err;
+
+	return from_document( *out._doc, out._value );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+inline error from_file( const std::string &fileName, document_holder<T> &out )
+{
+	out._value = T();
+	if ( auto err = from_file( fileName, out.target() ) )
+		return err;
+
+	return from_document( *out._doc, out._value );
 }
 
 } // json5
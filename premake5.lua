@@ -5,8 +5,9 @@ workspace "json5"
 	-- Target architecture
 	architecture "x86_64"
 
-	-- Configuration settings
-	configurations { "Debug", "Release" }
+	-- Configuration settings, 'Document' builds reflection text paths through a temporary json5::document,
+	-- 'Instrumented' compiles in the parse/write instrumentation hooks, 'Allocations' the allocation hooks only
+	configurations { "Debug", "Release", "ReleaseDocument", "ReleaseInstrumented", "ReleaseAllocations" }
 
 	-- Debug configuration
 	filter { "configurations:Debug" }
@@ -14,20 +15,37 @@ workspace "json5"
 		symbols "On"
 		optimize "Off"
 
-	-- Release configuration
-	filter { "configurations:Release" }
+	-- Release configurations
+	filter { "configurations:Release*" }
 		defines { "NDEBUG" }
 		optimize "Speed"
 		inlining "Auto"
 
+	filter { "configurations:*Document" }
+		defines { "JSON5_REFLECT_USE_DOCUMENT" }
+
+	filter { "configurations:*Instrumented" }
+		defines { "JSON5_INSTRUMENTATION" }
+
+	filter { "configurations:*Allocations" }
+		defines { "JSON5_ALLOCATION_TRACKING" }
+
 	filter { "language:not C#" }
+		cppdialect "C++20"
+
+	filter { "language:not C#", "toolset:msc*" }
 		defines { "_CRT_SECURE_NO_WARNINGS" }
 		characterset ("MBCS")
 		buildoptions { "/std:c++latest" }
 
+	filter { "system:windows" }
+		defines { "WIN32", "_AMD64_" }
+
+	filter { "system:not windows" }
+		links { "pthread" }
+
 	filter { }
 		targetdir ".bin/%{cfg.longname}/"
-		defines { "WIN32", "_AMD64_" }
 		--exceptionhandling "Off"
 		rtti "Off"
 		vectorextensions "AVX2"
@@ -40,3 +58,10 @@ project "test"
 	files { "test/**.cpp", "test/**.hpp", "include/**.hpp", "include/**.inl", "**.natvis" }
 	includedirs { "include" }
 	debugdir "test"
+
+project "bench"
+	language "C++"
+	kind "ConsoleApp"
+	files { "bench/**.cpp", "bench/**.hpp", "include/**.hpp", "include/**.inl" }
+	includedirs { "include" }
+	debugdir "bench"
@@ -1,11 +1,21 @@
 #include <json5/json5.hpp>
+#include <json5/json5_binary.hpp>
+#include <json5/json5_cbor.hpp>
+#include <json5/json5_files.hpp>
+#include <json5/json5_filter.hpp>
+#include <json5/json5_incremental.hpp>
 #include <json5/json5_input.hpp>
+#include <json5/json5_msgpack.hpp>
 #include <json5/json5_output.hpp>
+#include <json5/json5_parallel.hpp>
 #include <json5/json5_reflect.hpp>
 
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <set>
 #include <type_traits>
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -43,6 +53,21 @@ enum class MyEnum
 
 JSON5_ENUM( MyEnum, Zero, First, Second, Third )
 
+static_assert( json5::detail::enum_table<MyEnum>::names.size() == 4 );
+static_assert( json5::detail::enum_table<MyEnum>::names[2] == "Second" );
+static_assert( json5::detail::enum_table<MyEnum>::names.hashes[3] == json5::detail::hash_name( "Third" ) );
+static_assert( json5::detail::enum_table<MyEnum>::names.find( "First" ) == 1 );
+static_assert( json5::detail::enum_table<MyEnum>::names.find( "Fourth" ) == json5::detail::name_table<4>::npos );
+static_assert( json5::detail::enum_table<MyEnum>::index.dense );
+static_assert( json5::detail::enum_table<MyEnum>::index.find( MyEnum::Third ) == 3 );
+
+enum class SparseEnum { A = -5, B = 100, C = 7 };
+JSON5_ENUM( SparseEnum, A, B, C )
+
+static_assert( !json5::detail::enum_table<SparseEnum>::index.dense );
+static_assert( json5::detail::enum_table<SparseEnum>::index.find( SparseEnum::B ) == 1 );
+static_assert( json5::detail::enum_table<SparseEnum>::index.find( SparseEnum( 8 ) ) == json5::detail::enum_index<SparseEnum, 3>::npos );
+
 struct BarBase
 {
 	std::string name;
@@ -57,6 +82,59 @@ struct Bar : BarBase
 
 JSON5_CLASS_INHERIT( Bar, BarBase, age )
 
+struct Wide
+{
+	int f00 = 0;
+	int f01 = 1;
+	int f02 = 2;
+	int f03 = 3;
+	int f04 = 4;
+	int f05 = 5;
+	int f06 = 6;
+	int f07 = 7;
+	int f08 = 8;
+	int f09 = 9;
+	int f10 = 10;
+	int f11 = 11;
+	int f12 = 12;
+	int f13 = 13;
+	int f14 = 14;
+	int f15 = 15;
+	int f16 = 16;
+	int f17 = 17;
+	int f18 = 18;
+	int f19 = 19;
+	int f20 = 20;
+	int f21 = 21;
+	int f22 = 22;
+	int f23 = 23;
+};
+
+JSON5_CLASS( Wide, f00, f01, f02, f03, f04, f05, f06, f07, f08, f09, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23 )
+
+// Largest member count supported by the reflection macros
+struct Widest
+{
+	int w000 = 0, w001 = 1, w002 = 2, w003 = 3, w004 = 4, w005 = 5, w006 = 6, w007 = 7, w008 = 8, w009 = 9, w010 = 10, w011 = 11, w012 = 12, w013 = 13, w014 = 14, w015 = 15;
+	int w016 = 16, w017 = 17, w018 = 18, w019 = 19, w020 = 20, w021 = 21, w022 = 22, w023 = 23, w024 = 24, w025 = 25, w026 = 26, w027 = 27, w028 = 28, w029 = 29, w030 = 30, w031 = 31;
+	int w032 = 32, w033 = 33, w034 = 34, w035 = 35, w036 = 36, w037 = 37, w038 = 38, w039 = 39, w040 = 40, w041 = 41, w042 = 42, w043 = 43, w044 = 44, w045 = 45, w046 = 46, w047 = 47;
+	int w048 = 48, w049 = 49, w050 = 50, w051 = 51, w052 = 52, w053 = 53, w054 = 54, w055 = 55, w056 = 56, w057 = 57, w058 = 58, w059 = 59, w060 = 60, w061 = 61, w062 = 62, w063 = 63;
+	int w064 = 64, w065 = 65, w066 = 66, w067 = 67, w068 = 68, w069 = 69, w070 = 70, w071 = 71, w072 = 72, w073 = 73, w074 = 74, w075 = 75, w076 = 76, w077 = 77, w078 = 78, w079 = 79;
+	int w080 = 80, w081 = 81, w082 = 82, w083 = 83, w084 = 84, w085 = 85, w086 = 86, w087 = 87, w088 = 88, w089 = 89, w090 = 90, w091 = 91, w092 = 92, w093 = 93, w094 = 94, w095 = 95;
+	int w096 = 96, w097 = 97, w098 = 98, w099 = 99, w100 = 100, w101 = 101, w102 = 102, w103 = 103, w104 = 104, w105 = 105, w106 = 106, w107 = 107, w108 = 108, w109 = 109, w110 = 110, w111 = 111;
+	int w112 = 112, w113 = 113, w114 = 114, w115 = 115, w116 = 116, w117 = 117, w118 = 118, w119 = 119, w120 = 120, w121 = 121, w122 = 122, w123 = 123, w124 = 124, w125 = 125, w126 = 126, w127 = 127;
+};
+
+JSON5_CLASS( Widest,
+                 w000, w001, w002, w003, w004, w005, w006, w007, w008, w009, w010, w011, w012, w013, w014, w015,
+                 w016, w017, w018, w019, w020, w021, w022, w023, w024, w025, w026, w027, w028, w029, w030, w031,
+                 w032, w033, w034, w035, w036, w037, w038, w039, w040, w041, w042, w043, w044, w045, w046, w047,
+                 w048, w049, w050, w051, w052, w053, w054, w055, w056, w057, w058, w059, w060, w061, w062, w063,
+                 w064, w065, w066, w067, w068, w069, w070, w071, w072, w073, w074, w075, w076, w077, w078, w079,
+                 w080, w081, w082, w083, w084, w085, w086, w087, w088, w089, w090, w091, w092, w093, w094, w095,
+                 w096, w097, w098, w099, w100, w101, w102, w103, w104, w105, w106, w107, w108, w109, w110, w111,
+                 w112, w113, w114, w115, w116, w117, w118, w119, w120, w121, w122, w123, w124, w125, w126, w127 )
+
 //---------------------------------------------------------------------------------------------------------------------
 int main( int argc, char *argv[] )
 {
@@ -96,6 +174,143 @@ int main( int argc, char *argv[] )
 		std::cout << json5::to_string( doc );
 	}
 
+	/// Stream writer (no document)
+	{
+		json5::document doc;
+		json5::builder b( doc );
+
+		b.push_object();
+		{
+			b["x"] = b.new_string( "Hello!" );
+			b["y"] = 123.0;
+
+			b.push_array();
+			{
+				b += b.new_string( "a" );
+				b += true;
+				b += json5::value();
+			}
+			b["arr"] = b.pop();
+
+			b.push_object();
+			b["empty"] = b.pop();
+		}
+		b.pop();
+
+		std::ostringstream os;
+		json5::stream_writer w( os );
+		w.begin_object();
+		{
+			w.key( "x" ).value( "Hello!" );
+			w.key( "y" ).value( 123 );
+			w.key( "arr" ).begin_array().value( "a" ).value( true ).null().end_array();
+			w.key( "empty" ).begin_object().end_object();
+		}
+		w.end_object();
+
+		if ( os.str() == json5::to_string( doc ) )
+			std::cout << "stream_writer == to_string" << std::endl;
+		else
+			std::cout << "stream_writer != to_string" << std::endl;
+
+#if defined( NDEBUG )
+		// Unbalanced calls are ignored and fail the stream (debug builds assert instead)
+		std::ostringstream osUnbalanced;
+		json5::stream_writer wu( osUnbalanced, json5::writer_params{ "", "", true } );
+		wu.end_array().key( "x" ).begin_object().end_array();
+
+		// Values in an object need a key, keys need a value
+		std::ostringstream osNoKey, osTwoKeys, osNoValue;
+		json5::stream_writer( osNoKey, json5::writer_params{ "", "", true } ).begin_object().value( 1 ).key( "a" ).value( 2 ).end_object();
+		json5::stream_writer( osTwoKeys, json5::writer_params{ "", "", true } ).begin_object().key( "a" ).key( "b" ).value( 2 ).end_object();
+		json5::stream_writer( osNoValue, json5::writer_params{ "", "", true } ).begin_object().key( "a" ).end_object();
+
+		if ( osUnbalanced.fail() && osUnbalanced.str().empty() && osNoKey.fail() && osNoKey.str() == "{" &&
+		     osTwoKeys.fail() && osTwoKeys.str() == "{a:" && osNoValue.fail() && osNoValue.str() == "{a:" )
+			std::cout << "stream_writer(unbalanced) failed" << std::endl;
+		else
+			std::cout << "stream_writer(unbalanced) did not fail: " << osUnbalanced.str() << " " << osNoKey.str() << " "
+			          << osTwoKeys.str() << " " << osNoValue.str() << std::endl;
+#endif
+
+		// Integral numbers out of int64 range and non-finite numbers
+		std::ostringstream os1, os2;
+		const double inf = std::numeric_limits<double>::infinity();
+
+		json5::stream_writer w1( os1, json5::writer_params{ "", "", true } );
+		w1.begin_array().value( 1e300 ).value( -9223372036854775808.0 ).value( inf ).value( -inf ).value( std::nan( "" ) ).end_array();
+
+		json5::stream_writer w2( os2, json5::writer_params{ "", "", true, true } );
+		w2.begin_array().value( inf ).value( std::nan( "" ) ).end_array();
+
+		if ( os1.str() == "[1e+300,-9223372036854775808,Infinity,-Infinity,NaN]" && os2.str() == "[null,null]" )
+			std::cout << "stream_writer(1e300, inf, nan) == [1e+300,Infinity,NaN]" << std::endl;
+		else
+			std::cout << "stream_writer(1e300, inf, nan) != [1e+300,Infinity,NaN]: " << os1.str() << " " << os2.str() << std::endl;
+
+		// Escaped UTF-8 sequences cut off by the end of the string are not read past it
+		std::ostringstream os3;
+		auto truncated = std::make_unique<char[]>( 5 );
+		std::memcpy( truncated.get(), "\xc3\xa9" "b\xf0\x9f", 5 );
+
+		json5::stream_writer w3( os3, json5::writer_params{ "", "", true, false, true } );
+		w3.value( std::string_view( truncated.get(), 5 ) );
+
+		if ( os3.str() == "\"\\u00e9b\\ufffd\\ufffd\"" )
+			std::cout << "stream_writer(truncated UTF-8) == \"\\u00e9b\\ufffd\\ufffd\"" << std::endl;
+		else
+			std::cout << "stream_writer(truncated UTF-8) != \"\\u00e9b\\ufffd\\ufffd\": " << os3.str() << std::endl;
+
+		// Non-finite literals are parsed back, signed forms too
+		json5::document nonFinite;
+		PrintError( json5::from_string( "[ Infinity, -Infinity, +Infinity, NaN, -NaN ]", nonFinite ) );
+
+		if ( std::string out; json5::to_string( out, nonFinite, json5::writer_params{ "", "", true } ), out == "[Infinity,-Infinity,Infinity,NaN,NaN]" )
+			std::cout << "from_string([Infinity, NaN]) == [Infinity,NaN]" << std::endl;
+		else
+			std::cout << "from_string([Infinity, NaN]) != [Infinity,NaN]: " << out << std::endl;
+
+		// NaN computed at runtime (sign bit set on x86) stays a number in a document
+		struct Computed
+		{
+			double d = 0.0;
+
+			JSON5_MEMBERS( d )
+		};
+
+		volatile double zero = 0.0;
+		Computed computed{ zero / zero };
+
+		json5::document computedDoc;
+		json5::to_document( computedDoc, computed );
+
+		std::string viaDocument, direct;
+		json5::to_string( viaDocument, computedDoc, json5::writer_params{ "", "", true } );
+		json5::to_string( direct, computed, json5::writer_params{ "", "", true } );
+
+		if ( viaDocument == "{d:NaN}" && direct == viaDocument && computedDoc["d"].is_number() )
+			std::cout << "to_document(0.0 / 0.0) == {d:NaN}" << std::endl;
+		else
+			std::cout << "to_document(0.0 / 0.0) != {d:NaN}: " << viaDocument << " " << direct << std::endl;
+
+		struct Limits
+		{
+			double high = std::numeric_limits<double>::infinity();
+			double low = -std::numeric_limits<double>::infinity();
+			double undefined = std::nan( "" );
+
+			JSON5_MEMBERS( high, low, undefined )
+		};
+
+		Limits limits1, limits2 = { 0.0, 0.0, 0.0 };
+		PrintError( json5::from_string( json5::to_string( limits1 ), limits2 ) );
+
+		if ( limits2.high == inf && limits2.low == -inf && std::isnan( limits2.undefined ) )
+			std::cout << "from_string(to_string(limits)) == limits" << std::endl;
+		else
+			std::cout << "from_string(to_string(limits)) != limits" << std::endl;
+	}
+
 	/// Load from file
 	{
 		json5::document doc;
@@ -148,6 +363,18 @@ int main( int argc, char *argv[] )
 			std::cout << "doc1 != doc2" << std::endl;
 	}
 
+	/// Default constructed and parsed null values
+	{
+		json5::document doc;
+		PrintError( json5::from_string( "[ null, 0 ]", doc ) );
+
+		json5::array_view arr( doc );
+		if ( json5::value().is_null() && arr[0].is_null() && arr[1].is_number() && json5::to_string( doc, json5::writer_params{ "", "", true } ) == "[null,0]" )
+			std::cout << "value() == null" << std::endl;
+		else
+			std::cout << "value() != null" << std::endl;
+	}
+
 	/// String line breaks
 	{
 		json5::document doc;
@@ -178,9 +405,42 @@ int main( int argc, char *argv[] )
 		Foo foo1;
 		json5::to_file( "Foo.json5", foo1 );
 
+		{
+			json5::document doc;
+			json5::to_document( doc, foo1 );
+
+			if ( json5::to_string( foo1 ) == json5::to_string( doc ) )
+				std::cout << "to_string(foo1) == to_string(to_document(foo1))" << std::endl;
+			else
+				std::cout << "to_string(foo1) != to_string(to_document(foo1))" << std::endl;
+		}
+
 		Foo foo2;
 		json5::from_file( "Foo.json5", foo2 );
 
+		if ( json5::to_string( foo1 ) == json5::to_string( foo2 ) )
+			std::cout << "to_string(foo1) == to_string(foo2)" << std::endl;
+		else
+			std::cout << "to_string(foo1) != to_string(foo2)" << std::endl;
+
+		// Unknown keys are skipped, missing keys are left untouched
+		Foo foo3;
+		PrintError( json5::from_string( "{ unknown: { a: [1, 'x', null], b: true }, x: 7, e: 'Third', numbers: null, }", foo3 ) );
+		std::cout << "foo3: " << json5::to_string( foo3, json5::writer_params{ "", "", true } ) << std::endl;
+
+		// Text is read in place, from any buffer
+		std::vector<char> buffer = { '{', ' ', 'x', ':', ' ', '9', ' ', '}', '#' };
+		Foo foo4;
+		PrintError( json5::from_string( std::string_view( buffer.data(), buffer.size() - 1 ), foo4 ) );
+
+		if ( foo4.x == 9 )
+			std::cout << "from_string(string_view) == { x: 9 }" << std::endl;
+		else
+			std::cout << "from_string(string_view) != { x: 9 }" << std::endl;
+
+		// Type mismatch is reported with position
+		PrintError( json5::from_string( "{ x: 7,\n y: 'text' }", foo3 ) );
+
 		/*
 		if ( foo1 == foo2 )
 			std::cout << "foo1 == foo2" << std::endl;
@@ -189,5 +449,724 @@ int main( int argc, char *argv[] )
 		*/
 	}
 
+	/// Wide reflected struct (more than 16 members)
+	{
+		Wide wide1;
+		wide1.f23 = -1;
+
+		Wide wide2;
+		PrintError( json5::from_string( json5::to_string( wide1 ), wide2 ) );
+
+		if ( wide2.f23 == -1 && json5::to_string( wide1 ) == json5::to_string( wide2 ) )
+			std::cout << "wide1 == wide2" << std::endl;
+		else
+			std::cout << "wide1 != wide2" << std::endl;
+
+		static_assert( json5::detail::class_wrapper<Widest>::names.size() == 128 );
+
+		// Every member differs from its default
+		std::string text = "{";
+		for ( int i = 0; i < 128; ++i )
+		{
+			char member[32];
+			snprintf( member, sizeof( member ), "w%03d:%d,", i, -1 - i );
+			text += member;
+		}
+		text += "}";
+
+		Widest widest1;
+		PrintError( json5::from_string( text, widest1 ) );
+
+		Widest widest2;
+		PrintError( json5::from_string( json5::to_string( widest1 ), widest2 ) );
+
+		json5::document doc;
+		json5::to_document( doc, widest1 );
+
+		Widest widest3;
+		PrintError( json5::from_document( doc, widest3 ) );
+
+		if ( widest1.w000 == -1 && widest1.w064 == -65 && widest1.w127 == -128 &&
+		     json5::to_string( widest1 ) == json5::to_string( widest2 ) && json5::to_string( widest1 ) == json5::to_string( widest3 ) )
+			std::cout << "widest1 == widest2 == widest3" << std::endl;
+		else
+			std::cout << "widest1 != widest2 != widest3" << std::endl;
+	}
+
+	/// Numeric arrays read in bulk from a document
+	{
+		struct Mesh
+		{
+			std::vector<float> vertices;
+			std::array<int, 3> indices = { };
+
+			JSON5_MEMBERS( vertices, indices )
+		};
+
+		json5::document doc;
+		json5::from_string( "{ vertices: [ 0.5, -1, 2.25, 1e3 ], indices: [ 0, 1, 2 ] }", doc );
+
+		Mesh mesh;
+		PrintError( json5::from_document( doc, mesh ) );
+
+		if ( mesh.vertices == std::vector<float>{ 0.5f, -1.0f, 2.25f, 1000.0f } && mesh.indices == std::array<int, 3>{ 0, 1, 2 } )
+			std::cout << "mesh == expected" << std::endl;
+		else
+			std::cout << "mesh != expected" << std::endl;
+
+		json5::from_string( "{ vertices: [ 0.5, 'x' ] }", doc );
+		PrintError( json5::from_document( doc, mesh ) );
+	}
+
+	/// Repeated decodes reuse existing containers
+	{
+		struct Config
+		{
+			std::vector<Bar> bars;
+			std::map<std::string, std::vector<int>> groups;
+			std::unordered_map<std::string, float> weights;
+
+			JSON5_MEMBERS( bars, groups, weights )
+		};
+
+		const char *text = "{ bars: [ { name: 'a', age: 1 }, { name: 'b', age: 2 } ], groups: { x: [ 1, 2, 3 ], y: [ 4 ] }, weights: { p: 0.5, q: 2 } }";
+
+		json5::document doc;
+		Config config;
+		PrintError( json5::update_from_string( text, doc, config ) );
+
+		const Bar *bars = config.bars.data();
+		const int *group = config.groups["x"].data();
+		const float *weight = &config.weights["q"];
+
+		PrintError( json5::update_from_string( text, doc, config ) );
+		PrintError( json5::update_from_string( "{ groups: { x: [ 5, 6 ], z: [ 7 ] } }", doc, config ) );
+
+		if ( config.bars.data() == bars && config.groups["x"].data() == group && &config.weights["q"] == weight &&
+		     config.groups.size() == 2 && config.groups["x"] == std::vector<int>{ 5, 6 } && config.groups["z"] == std::vector<int>{ 7 } )
+			std::cout << "config storage reused" << std::endl;
+		else
+			std::cout << "config storage not reused" << std::endl;
+
+		// Duplicate keys do not keep removed keys alive, recycled nodes keep their capacity, buckets are kept
+		PrintError( json5::update_from_string( "{ groups: { x: [ 1 ], x: [ 2 ] } }", doc, config ) );
+		bool duplicates = config.groups.size() == 1 && config.groups["x"] == std::vector<int>{ 2 };
+
+		size_t bucketCount = config.weights.bucket_count();
+		PrintError( json5::update_from_string( "{ groups: { w: [ 7, 8 ] }, weights: { r: 1, q: 3 } }", doc, config ) );
+
+		if ( duplicates && config.groups.size() == 1 && config.groups["w"].data() == group && config.groups["w"] == std::vector<int>{ 7, 8 } &&
+		     config.weights.size() == 2 && config.weights["r"] == 1.0f && &config.weights["q"] == weight && config.weights.bucket_count() == bucketCount )
+			std::cout << "config map nodes recycled" << std::endl;
+		else
+			std::cout << "config map nodes not recycled" << std::endl;
+
+#if defined( JSON5_INSTRUMENTATION ) || defined( JSON5_ALLOCATION_TRACKING )
+		// Same-shaped input with a long-lived document and parse context does not allocate
+		json5::parse_context context;
+		PrintError( json5::update_from_string( text, doc, context, config ) );
+		PrintError( json5::update_from_string( text, doc, context, config ) );
+
+		json5::allocation_tracker tracker;
+		for ( int i = 0; i < 10; ++i )
+			PrintError( json5::update_from_string( text, doc, context, config ) );
+
+		if ( tracker.total() == 0 && config.bars.data() == bars )
+			std::cout << "update_from_string allocations == 0" << std::endl;
+		else
+			std::cout << "update_from_string allocations != 0" << std::endl;
+#endif
+
+		// A node recycled from a removed key does not carry that key's members over to the new key
+		std::map<std::string, Bar> named;
+		PrintError( json5::update_from_string( "{ x: { name: 'a', age: 2 } }", doc, named ) );
+		PrintError( json5::update_from_string( "{ y: { name: 'b' } }", doc, named ) );
+
+		if ( named.size() == 1 && named["y"].name == "b" && named["y"].age == 0 )
+			std::cout << "recycled map node reset" << std::endl;
+		else
+			std::cout << "recycled map node not reset" << std::endl;
+
+		// Neither does a reused vector element inherit members of the record it held before
+		std::vector<Bar> listed;
+		PrintError( json5::update_from_string( "[ { name: 'a', age: 5 } ]", doc, listed ) );
+		PrintError( json5::update_from_string( "[ { name: 'b' } ]", doc, listed ) );
+
+		if ( listed.size() == 1 && listed[0].name == "b" && listed[0].age == 0 )
+			std::cout << "reused vector element reset" << std::endl;
+		else
+			std::cout << "reused vector element not reset" << std::endl;
+	}
+
+	/// Parallel read of a large root array
+	{
+		std::vector<Bar> bars1( 100000 );
+		for ( size_t i = 0; i < bars1.size(); ++i )
+			bars1[i] = Bar{ { "Bar " + std::to_string( i ) }, int( i ) };
+
+		json5::document doc;
+		json5::to_document( doc, bars1 );
+
+		std::vector<Bar> bars2;
+		{
+			Stopwatch sw{ "Parallel from_document" };
+			PrintError( json5::from_document_parallel( doc, bars2 ) );
+		}
+
+		if ( json5::to_string( bars1 ) == json5::to_string( bars2 ) )
+			std::cout << "bars1 == bars2" << std::endl;
+		else
+			std::cout << "bars1 != bars2" << std::endl;
+
+		// Parallel filter, matches in document order
+		std::vector<json5::value> names1, names2, all1, all2;
+		{
+			Stopwatch sw{ "Filter */name" };
+			names1 = json5::filter( doc, "*/name" );
+		}
+
+		{
+			Stopwatch sw{ "Parallel filter */name" };
+			names2 = json5::filter_parallel( doc, "*/name" );
+		}
+
+		all1 = json5::filter( doc, "**" );
+		all2 = json5::filter_parallel( doc, "**", json5::parallel_params{ 4, 7 } );
+
+		json5::filter_set patterns{ "[10:20]/age", "[?(@.age == 5000)]/name" };
+		auto sets1 = json5::filter( doc, patterns );
+		auto sets2 = json5::filter_parallel( doc, patterns, json5::parallel_params{ 3, 100 } );
+
+		if ( names1.size() == bars1.size() && names1 == names2 && all1 == all2 && sets1 == sets2 && sets1[0].size() == 10 &&
+		     sets1[1].size() == 1 )
+			std::cout << "filter_parallel == filter" << std::endl;
+		else
+			std::cout << "filter_parallel != filter" << std::endl;
+
+		// Parallel serialization, same text as sequential
+		std::string text1, text2;
+		{
+			Stopwatch sw{ "to_string" };
+			json5::to_string( text1, doc );
+		}
+
+		{
+			Stopwatch sw{ "Parallel to_string" };
+			json5::to_string_parallel( text2, doc );
+		}
+
+		json5::writer_params compact;
+		compact.compact = true;
+		compact.json_compatible = true;
+
+		std::vector<json5::document> docs( 3 );
+		json5::from_string( "{ a: [ 1, { b: 'x' } ] }", docs[1] );
+		json5::from_string( "[ [], {}, [ null ] ]", docs[2] );
+		auto texts = json5::to_string_parallel( docs, compact, json5::parallel_params{ 2, 1 } );
+
+		if ( text1 == text2 && json5::to_string_parallel( doc, compact, json5::parallel_params{ 4, 7 } ) == json5::to_string( doc, compact ) &&
+		     json5::to_string_parallel( docs[2], json5::writer_params(), json5::parallel_params{ 2, 1 } ) == json5::to_string( docs[2] ) &&
+		     texts.size() == 3 && texts[0] == json5::to_string( docs[0], compact ) && texts[1] == json5::to_string( docs[1], compact ) &&
+		     texts[2] == json5::to_string( docs[2], compact ) )
+			std::cout << "to_string_parallel == to_string" << std::endl;
+		else
+			std::cout << "to_string_parallel != to_string" << std::endl;
+
+		std::string text3;
+		json5::to_string_parallel( text3, bars1, json5::writer_params(), json5::parallel_params{ 3, 1000 } );
+		if ( text3 == json5::to_string( bars1 ) )
+			std::cout << "to_string_parallel(bars1) == to_string(bars1)" << std::endl;
+		else
+			std::cout << "to_string_parallel(bars1) != to_string(bars1)" << std::endl;
+
+		json5::from_string( "[ { age: 1 }, { age: 'x' }, { age: 3 }, { age: [] } ]", doc );
+		size_t errorIndex = 0;
+		auto err = json5::from_document_parallel( doc, bars2, json5::parallel_params{ 4, 1 }, &errorIndex );
+
+		if ( err.type == json5::error::number_expected && errorIndex == 1 )
+			std::cout << "from_document_parallel(doc, bars2) errorIndex == 1" << std::endl;
+		else
+			std::cout << "from_document_parallel(doc, bars2) errorIndex != 1" << std::endl;
+	}
+
+	/// Incremental snapshots of a reflected object
+	{
+		struct State
+		{
+			int frame = 0;
+			std::vector<Bar> bars = { Bar{ { "a" }, 1 }, Bar{ { "b" }, 2 } };
+			std::map<std::string, float> stats = { { "x", 0.5f } };
+			int grid[2][2] = { { 1, 2 }, { 3, 4 } };
+
+			JSON5_MEMBERS( frame, bars, stats, grid )
+		};
+
+		State state;
+		json5::incremental_writer<State> snapshots;
+
+		size_t changed1 = snapshots.update( state );
+		state.frame = 1;
+		state.bars[1].age = 3;
+		size_t changed2 = snapshots.update( state );
+
+		if ( changed1 == 4 && changed2 == 2 && snapshots.text() == json5::to_string( state ) )
+			std::cout << "snapshots.text() == to_string(state)" << std::endl;
+		else
+			std::cout << "snapshots.text() != to_string(state)" << std::endl;
+
+		// Merge patch diffs reflected members and maps key by key, removed keys are 'null'
+		json5::incremental_writer<State> patches( json5::writer_params{ "", "", true } );
+		patches.update( state );
+
+		state.bars[0].name = "c";
+		state.stats.erase( "x" );
+		state.stats["y"] = 2.0f;
+		patches.update( state );
+
+		std::string patch = patches.patch();
+		if ( patch == "{bars:[{name:\"c\",age:1},{name:\"b\",age:3}],stats:{x:null,y:2}}" )
+			std::cout << "patch == {bars:[...],stats:{x:null,y:2}}" << std::endl;
+		else
+			std::cout << "patch != {bars:[...],stats:{x:null,y:2}}: " << patch << std::endl;
+	}
+
+	/// Binary encoding of reflected types
+	{
+		struct Record
+		{
+			int id = -42;
+			MyEnum e = MyEnum::Third;
+			std::vector<float> samples = { 0.5f, -2.0f, 1e6f };
+			std::map<std::string, Bar> bars = { { "x", Bar{ { "a" }, 1 } } };
+			double grid[2][2] = { { 1, 2 }, { 3, 4.5 } };
+			bool flag = true;
+
+			JSON5_MEMBERS( id, e, samples, bars, grid, flag )
+		};
+
+		std::vector<Record> records1( 100 );
+		for ( size_t i = 0; i < records1.size(); ++i )
+			records1[i].id = int( i ) - 1000;
+
+		std::string text;
+		std::vector<uint8_t> binary;
+		std::vector<Record> records2, records3;
+		json5::to_string( text, records1 );
+		json5::to_binary( binary, records1 );
+		PrintError( json5::from_string( text, records2 ) );
+		PrintError( json5::from_binary( binary, records3 ) );
+
+		std::cout << "Records text: " << text.size() << " bytes, binary: " << binary.size() << " bytes" << std::endl;
+
+		if ( json5::to_string( records2 ) == json5::to_string( records3 ) )
+			std::cout << "from_string(records) == from_binary(records)" << std::endl;
+		else
+			std::cout << "from_string(records) != from_binary(records)" << std::endl;
+
+		// Truncated data is reported with its byte offset
+		binary.resize( binary.size() - 1 );
+		PrintError( json5::from_binary( binary, records3 ) );
+
+		// std::vector<bool> is written item by item
+		std::vector<bool> mask1 = { true, false, true, true }, mask2;
+		json5::to_binary( binary, mask1 );
+		PrintError( json5::from_binary( binary, mask2 ) );
+
+		if ( mask1 == mask2 )
+			std::cout << "from_binary(mask) == mask" << std::endl;
+		else
+			std::cout << "from_binary(mask) != mask" << std::endl;
+	}
+
+	/// CBOR and MessagePack conversion
+	{
+		json5::document doc1, doc2, doc3, doc4;
+		PrintError( json5::from_file( "twitter.json", doc1 ) );
+
+		std::vector<uint8_t> cbor, msgpack;
+		{
+			Stopwatch sw{ "Twitter to_cbor" };
+			json5::to_cbor( cbor, doc1 );
+		}
+		{
+			Stopwatch sw{ "Twitter from_cbor" };
+			PrintError( json5::from_cbor( cbor, doc2 ) );
+		}
+		{
+			Stopwatch sw{ "Twitter to_msgpack" };
+			json5::to_msgpack( msgpack, doc1 );
+		}
+		{
+			Stopwatch sw{ "Twitter from_msgpack" };
+			PrintError( json5::from_msgpack( msgpack, doc3 ) );
+		}
+
+		std::ostringstream os;
+		json5::to_msgpack( os, doc1 );
+
+		if ( doc1 == doc2 && doc1 == doc3 && os.str() == std::string( msgpack.begin(), msgpack.end() ) )
+			std::cout << "doc1 == from_cbor(to_cbor(doc1)) == from_msgpack(to_msgpack(doc1))" << std::endl;
+		else
+			std::cout << "doc1 != from_cbor(to_cbor(doc1)) != from_msgpack(to_msgpack(doc1))" << std::endl;
+
+		// Numeric arrays as typed arrays
+		json5::from_string( "{ xs: [ 0.5, -1, 1e300 ], n: [ 1, 'a' ] }", doc1 );
+		PrintError( json5::from_cbor( json5::to_cbor( doc1, json5::cbor_params{ true } ), doc4 ) );
+
+		if ( doc1 == doc4 )
+			std::cout << "doc1 == from_cbor(to_cbor(doc1, typed_arrays))" << std::endl;
+		else
+			std::cout << "doc1 != from_cbor(to_cbor(doc1, typed_arrays))" << std::endl;
+
+		// NaN payloads with sign and type bits set must not turn into strings, arrays or objects
+		const std::vector<std::vector<uint8_t>> cborNaNs = {
+			{ 0x81, 0xfb, 0xff, 0xf6, 0x7f, 0x00, 0x00, 0x00, 0x10, 0x00 },
+			{ 0x81, 0xfa, 0xff, 0xff, 0xff, 0xff },
+			{ 0xd8, 0x56, 0x48, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf2, 0xff },
+			{ 0xd8, 0x55, 0x44, 0x01, 0x00, 0xc0, 0xff },
+		};
+		const std::vector<std::vector<uint8_t>> msgpackNaNs = {
+			{ 0x91, 0xcb, 0xff, 0xf2, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 },
+			{ 0x91, 0xca, 0xff, 0xff, 0xff, 0xff },
+		};
+
+		auto isNaNArray = []( const json5::document &doc ) {
+			json5::array_view arr( doc );
+			return arr.size() == 1 && arr[0].is_number() && std::isnan( arr[0].get<double>() ) && !json5::to_string( doc ).empty();
+		};
+
+		bool allNaN = true;
+		for ( const auto &bytes : cborNaNs )
+			allNaN &= !json5::from_cbor( bytes, doc4 ) && isNaNArray( doc4 );
+		for ( const auto &bytes : msgpackNaNs )
+			allNaN &= !json5::from_msgpack( bytes, doc4 ) && isNaNArray( doc4 );
+
+		if ( allNaN )
+			std::cout << "from_cbor(NaN payloads) == from_msgpack(NaN payloads) == [NaN]" << std::endl;
+		else
+			std::cout << "from_cbor(NaN payloads) != from_msgpack(NaN payloads) != [NaN]" << std::endl;
+	}
+
+	/// Compiled filter patterns
+	{
+		json5::document doc;
+		PrintError( json5::from_file( "twitter.json", doc ) );
+
+		json5::compiled_filter pattern( "statuses/*/ 'user' /screen_name" );
+		auto names1 = json5::filter( doc, pattern );
+		auto names2 = json5::filter( doc, "statuses/*/user/screen_name" );
+
+		size_t count = 0;
+		{
+			Stopwatch sw{ "Compiled filter x100" };
+			for ( int i = 0; i < 100; ++i )
+				json5::filter( doc, pattern, [&count]( const json5::value & ) { ++count; } );
+		}
+
+		if ( !names1.empty() && names1 == names2 && count == names1.size() * 100 )
+			std::cout << "filter(compiled) == filter(string)" << std::endl;
+		else
+			std::cout << "filter(compiled) != filter(string)" << std::endl;
+
+		// Stacked '**' must not report the same value more than once
+		auto ids1 = json5::filter( doc, "**/id_str" );
+		auto ids2 = json5::filter( doc, "**/**/**/id_str" );
+		std::set<const void *> unique;
+		for ( const auto &v : ids2 )
+			unique.insert( v.get_c_str() );
+
+		{
+			Stopwatch sw{ "Filter **/**/**/id_str" };
+			json5::filter( doc, "**/**/**/id_str", []( const json5::value & ) { } );
+		}
+
+		if ( !ids1.empty() && ids1 == ids2 && unique.size() == ids2.size() )
+			std::cout << "filter(**/id_str) == filter(**/**/**/id_str)" << std::endl;
+		else
+			std::cout << "filter(**/id_str) != filter(**/**/**/id_str)" << std::endl;
+
+		// Many patterns in one pass
+		json5::filter_set patterns{ "statuses/*/user/screen_name", "statuses/*/id_str", "**/hashtags/*/text",
+		                            "search_metadata/count", "**/user/followers_count", "statuses/*/lang" };
+
+		std::vector<std::vector<json5::value>> perPattern;
+		{
+			Stopwatch sw{ "Filter set x100" };
+			for ( int i = 0; i < 100; ++i )
+				perPattern = json5::filter( doc, patterns );
+		}
+
+		{
+			Stopwatch sw{ "Separate filters x100" };
+			for ( int i = 0; i < 100; ++i )
+				for ( auto p : { "statuses/*/user/screen_name", "statuses/*/id_str", "**/hashtags/*/text",
+				                 "search_metadata/count", "**/user/followers_count", "statuses/*/lang" } )
+					json5::filter( doc, p, []( const json5::value & ) { } );
+		}
+
+		bool same = perPattern.size() == patterns.size() && perPattern[0] == names1;
+		same = same && perPattern[2] == json5::filter( doc, "**/hashtags/*/text" );
+		same = same && perPattern[4] == json5::filter( doc, "**/user/followers_count" );
+
+		if ( same )
+			std::cout << "filter(filter_set) == filter(pattern) for each pattern" << std::endl;
+		else
+			std::cout << "filter(filter_set) != filter(pattern) for each pattern" << std::endl;
+
+		// Indexes, slices and predicates
+		auto ids = json5::filter( doc, "statuses/*/id_str" );
+		auto first = json5::filter( doc, "statuses[0]/id_str" );
+		auto last = json5::filter( doc, "statuses[-1]/id_str" );
+		auto middle = json5::filter( doc, "statuses[1:-1]/id_str" );
+
+		auto japanese = json5::filter( doc, "statuses[?(@.lang == 'ja')]/id_str" );
+		auto other = json5::filter( doc, "statuses[?(@.lang != 'ja')]/id_str" );
+
+		if ( ids.size() > 2 && first.size() == 1 && first[0] == ids.front() && last.size() == 1 && last[0] == ids.back() &&
+		     middle.size() == ids.size() - 2 && japanese.size() + other.size() == ids.size() && !japanese.empty() )
+			std::cout << "filter(statuses[...]) == filter(statuses/*)" << std::endl;
+		else
+			std::cout << "filter(statuses[...]) != filter(statuses/*)" << std::endl;
+
+		// Lazy matching, stops early
+		std::vector<json5::value> lazy;
+		for ( auto v : json5::filter_range( doc, "statuses/*/id_str" ) )
+			lazy.push_back( v );
+
+		json5::value firstId;
+		bool found = json5::filter_first( doc, "**/id_str", firstId );
+
+		if ( lazy == ids && found && firstId == json5::filter( doc, "**/id_str" )[0] &&
+		     json5::filter_count( doc, "statuses/*/id_str" ) == ids.size() && json5::filter_count( doc, "**", 3 ) == 3 &&
+		     !json5::filter_first( doc, "no/such/key", firstId ) )
+			std::cout << "filter_range == filter" << std::endl;
+		else
+			std::cout << "filter_range != filter" << std::endl;
+	}
+
+	/// Batch file loading
+	{
+		auto dir = std::filesystem::temp_directory_path() / "json5_test_batch";
+		std::filesystem::create_directories( dir );
+
+		std::vector<std::filesystem::path> paths;
+		for ( int i = 0; i < 40; ++i )
+		{
+			paths.push_back( dir / ( "batch_" + std::to_string( i ) + ".json5" ) );
+
+			std::ofstream ofs( paths.back() );
+			if ( i == 7 )
+				ofs << "{ broken: [ 1, 2 }";
+			else
+				ofs << "// File " << i << "\n{ id: " << i << ", name: 'file " << i << "', items: [ 1, 'two', { three: 3 } ] }";
+		}
+
+		paths.push_back( dir / "batch_missing.json5" );
+
+		json5::parallel_params pp;
+		pp.num_threads = 4;
+		pp.chunk_size = 3;
+		auto loaded = json5::load_files( paths, pp );
+
+		bool same = loaded.size() == paths.size();
+		json5::parse_context context;
+		for ( size_t i = 0; same && i < paths.size(); ++i )
+		{
+			json5::document doc, doc2;
+			auto err = json5::from_file( paths[i].string(), doc );
+			auto err2 = json5::from_file( paths[i], doc2, context );
+
+			same = err.type == loaded[i].err.type && err2.type == err.type && err.line == loaded[i].err.line &&
+			       err.column == loaded[i].err.column && ( err || ( doc == loaded[i].doc && doc2 == doc ) );
+		}
+
+		if ( same && loaded[7].err.type == json5::error::comma_expected && loaded[40].err.type == json5::error::could_not_open &&
+		     std::string_view( json5::object_view( loaded[12].doc )["name"].get_c_str() ) == "file 12" )
+			std::cout << "load_files == from_file" << std::endl;
+		else
+			std::cout << "load_files != from_file" << std::endl;
+
+		std::error_code ec;
+		std::filesystem::remove_all( dir, ec );
+	}
+
+	/// String views into a held document
+	{
+		struct Tagged
+		{
+			std::string_view id;
+			std::vector<std::string_view> tags;
+
+			JSON5_MEMBERS( id, tags )
+		};
+
+		json5::document_holder<Tagged> held;
+		PrintError( json5::from_string( "{ id: 'abc\\u0041', tags: [ 'x', 'y\\nz' ] }", held ) );
+
+		auto moved = std::move( held );
+		if ( moved->id == "abcA" && moved->tags.size() == 2 && moved->tags[1] == "y\nz" )
+			std::cout << "held->id == \"abcA\"" << std::endl;
+		else
+			std::cout << "held->id != \"abcA\"" << std::endl;
+
+		std::cout << "held: " << json5::to_string( *moved, json5::writer_params{ "", "", true } ) << std::endl;
+
+		// Moved-from holders can be read into again
+		auto taggedFile = ( std::filesystem::temp_directory_path() / "json5_test_Tagged.json5" ).string();
+		json5::to_file( taggedFile, *moved );
+		bool reread = !json5::from_string( "{ id: 'def' }", held ) && held->id == "def";
+
+		auto moved2 = std::move( held );
+		json5::document doc;
+		json5::from_string( "{ id: 'ghi', tags: [ 'w' ] }", doc );
+		reread &= !json5::from_document( std::move( doc ), held ) && held->id == "ghi" && held->tags.size() == 1;
+
+		auto moved3 = std::move( held );
+		reread &= !json5::from_file( taggedFile, held ) && held->id == "abcA" && held->tags[1] == "y\nz";
+		reread &= moved2->id == "def" && moved3->id == "ghi" && moved->id == "abcA";
+
+		std::error_code ec;
+		std::filesystem::remove( taggedFile, ec );
+
+		if ( reread )
+			std::cout << "from_string(moved-from held) == from_document(...) == from_file(...)" << std::endl;
+		else
+			std::cout << "from_string(moved-from held) != from_document(...) != from_file(...)" << std::endl;
+	}
+
+#if defined( JSON5_INSTRUMENTATION )
+	/// Instrumentation
+	{
+		struct LastStats : json5::instrument_sink
+		{
+			void record( const json5::instrument_stats &stats ) override { last = stats; histograms.record( stats ); }
+
+			json5::instrument_stats last;
+			json5::histogram_sink histograms;
+		};
+
+		LastStats sink;
+		json5::set_instrument_sink( &sink );
+
+		const std::string text = "{ a: [ 1, 2, { b: 'x' } ], c: null }";
+		json5::document doc;
+		PrintError( json5::from_string( text, doc ) );
+		auto parsed = sink.last;
+
+		auto out = json5::to_string( doc );
+		auto written = sink.last;
+
+		json5::set_instrument_sink( nullptr );
+		json5::from_string( text, doc );
+
+		if ( parsed.operation == json5::instrument_stats::parse && parsed.values == 7 && parsed.max_depth == 3 &&
+		     parsed.bytes == text.size() && parsed.tokenize_ns + parsed.build_ns + parsed.relink_ns <= parsed.total_ns + 1 &&
+		     written.operation == json5::instrument_stats::write && written.values == 7 && written.bytes == out.size() &&
+		     sink.histograms.parse().values.count() == 1 && sink.histograms.write().bytes.quantile( 0.5 ) >= out.size() )
+			std::cout << "instrument_stats == expected" << std::endl;
+		else
+			std::cout << "instrument_stats != expected" << std::endl;
+
+		// Values and depth written on worker threads are merged into the stats of the parallel call
+		json5::document items;
+		PrintError( json5::from_string( "[ [ 1, { a: 2 } ], [ 3 ], [ 4, 5 ], 6, [ 7 ], 8, [ [ 9 ] ], 10 ]", items ) );
+
+		json5::set_instrument_sink( &sink );
+		json5::to_string( items );
+		auto serial = sink.last;
+
+		json5::to_string_parallel( items, json5::writer_params(), json5::parallel_params{ 3, 2 } );
+		auto parallel = sink.last;
+
+		json5::set_instrument_sink( nullptr );
+
+		if ( parallel.values == serial.values && parallel.max_depth == serial.max_depth && parallel.bytes == serial.bytes )
+			std::cout << "instrument_stats(to_string_parallel) == instrument_stats(to_string)" << std::endl;
+		else
+			std::cout << "instrument_stats(to_string_parallel) != instrument_stats(to_string): " << parallel.values << "/" << serial.values
+			          << " values, depth " << parallel.max_depth << "/" << serial.max_depth << std::endl;
+
+		std::cout << "parse: " << parsed.total_ns << " ns (tokenize " << parsed.tokenize_ns << ", build " << parsed.build_ns
+		          << ", relink " << parsed.relink_ns << "), " << parsed.allocations << " allocations" << std::endl;
+	}
+#endif
+
+#if defined( JSON5_INSTRUMENTATION ) || defined( JSON5_ALLOCATION_TRACKING )
+	/// Allocation tracking
+	{
+		std::string text = "{ items: [";
+		for ( int i = 0; i < 300; ++i )
+			text += "{ id: " + std::to_string( i ) + ", name: 'item' },";
+
+		text += "], wide: {";
+		for ( int i = 0; i < 300; ++i )
+			text += "k" + std::to_string( i ) + ": " + std::to_string( i ) + ",";
+
+		text += "} }";
+
+		json5::document doc, doc2;
+		std::string out;
+		{
+			json5::allocation_tracker warmUp;
+			json5::from_string( text, doc );
+			json5::from_string( text, doc2 );
+			json5::to_string( out, doc );
+			if ( warmUp[json5::allocation_site::document] == 0 || warmUp[json5::allocation_site::output] == 0 )
+				std::cout << "allocation_tracker: nothing counted" << std::endl;
+		}
+
+		// Counts of a single call
+		auto track = []( const auto &func )
+		{
+			json5::allocation_tracker tracker;
+			func();
+			return tracker.counts();
+		};
+
+		// Reused document and output string do not grow again, 'wide' has more keys than fit on the stack
+		bool equal = false;
+		std::vector<json5::value> ids;
+		auto parseCounts = track( [&]() { json5::from_string( text, doc ); } );
+		auto writeCounts = track( [&]() { json5::to_string( out, doc ); } );
+		auto compareCounts = track( [&]() { equal = doc == doc2; } );
+		auto filterCounts = track( [&]() { ids = json5::filter( doc, "items/*/id" ); } );
+
+		if ( equal && ids.size() == 300 && parseCounts[json5::allocation_site::document] == 0 &&
+		     parseCounts[json5::allocation_site::builder] > 0 && writeCounts.total() == 0 &&
+		     compareCounts[json5::allocation_site::compare] == 2 && compareCounts.total() == 2 &&
+		     filterCounts[json5::allocation_site::filter] > 0 )
+			std::cout << "allocation_counts == expected" << std::endl;
+		else
+			std::cout << "allocation_counts != expected" << std::endl;
+	}
+#endif
+
+#if ( defined( JSON5_INSTRUMENTATION ) || defined( JSON5_ALLOCATION_TRACKING ) ) && !defined( JSON5_REFLECT_USE_DOCUMENT )
+	/// Nested containers are written directly, without intermediate documents
+	{
+		struct Nested
+		{
+			std::vector<std::vector<int>> rows = { { 1, 2 }, { 3 } };
+			double grid[2][2] = { { 1, 2 }, { 3, 4.5 } };
+			std::array<std::array<int, 2>, 2> pairs = { { { 1, 2 }, { 3, 4 } } };
+			std::vector<std::map<std::string, int>> maps = { { { "a", 1 } }, { { "b", 2 } } };
+
+			JSON5_MEMBERS( rows, grid, pairs, maps )
+		};
+
+		Nested nested;
+		std::string out;
+		json5::to_string( out, nested );
+
+		json5::allocation_tracker tracker;
+		json5::to_string( out, nested );
+
+		if ( tracker.counts().total() == 0 )
+			std::cout << "to_string(nested) allocations == 0" << std::endl;
+		else
+			std::cout << "to_string(nested) allocations != 0" << std::endl;
+	}
+#endif
+
 	return 0;
 }